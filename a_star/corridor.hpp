@@ -0,0 +1,63 @@
+#ifndef A_STAR_CORRIDOR_H_
+#define A_STAR_CORRIDOR_H_
+
+#include <cmath>
+#include <vector>
+
+// Coarse cells a fine search may visit, each with the meters left to the
+// goal along the coarse grid. Cells outside the corridor hold INFINITY.
+// Cell (ix, iy) covers [x0 + ix * cell_x, x0 + (ix + 1) * cell_x) along x.
+struct Corridor
+{
+    float x0;               // meter
+    float y0;               // meter
+    float cell_x;           // meter
+    float cell_y;           // meter
+    int nx;
+    int ny;
+    std::vector<float> cost_to_go;  // meter, iy * nx + ix
+
+    inline int index(float x, float y) const
+    {
+        const int ix{static_cast<int>(std::floor((x - x0) / cell_x))};
+        const int iy{static_cast<int>(std::floor((y - y0) / cell_y))};
+        if (ix < 0 || iy < 0 || ix >= nx || iy >= ny) return -1;
+        return iy * nx + ix;
+    }
+
+    inline bool contains(float x, float y) const
+    {
+        const int i{index(x, y)};
+        return i >= 0 && cost_to_go[i] < INFINITY;
+    }
+
+    // cost to go interpolated between the centers of the corridor cells around (x, y)
+    inline float cost(float x, float y) const
+    {
+        const int i{index(x, y)};
+        if (i < 0 || !(cost_to_go[i] < INFINITY)) return INFINITY;
+        const float u{(x - x0) / cell_x - 0.5f};
+        const float v{(y - y0) / cell_y - 0.5f};
+        const int ix{static_cast<int>(std::floor(u))};
+        const int iy{static_cast<int>(std::floor(v))};
+        const float fu{u - ix};
+        const float fv{v - iy};
+        float sum{0.0f};
+        float weight{0.0f};
+        for (int dy = 0; dy <= 1; ++dy) {
+            for (int dx = 0; dx <= 1; ++dx) {
+                const int cx{ix + dx};
+                const int cy{iy + dy};
+                if (cx < 0 || cy < 0 || cx >= nx || cy >= ny) continue;
+                const float c{cost_to_go[cy * nx + cx]};
+                if (!(c < INFINITY)) continue;
+                const float w{(dx ? fu : 1.0f - fu) * (dy ? fv : 1.0f - fv)};
+                sum += w * c;
+                weight += w;
+            }
+        }
+        return weight > 1.0e-6f ? sum / weight : cost_to_go[i];
+    }
+}; // struct Corridor
+
+#endif // A_STAR_CORRIDOR_H_
@@ -0,0 +1,219 @@
+#include "costmap.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "instrument.hpp"
+#include "math_util.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define LUT_STEPS_PER_CELL  8
+
+
+// out = status > 0 ? 0 : min(prev + 1, cap), for one row
+static void sweep_forward(const int8_t* status, const int16_t* prev, int16_t* out, int n, int16_t cap)
+{
+    int c{0};
+#if defined(__SSE2__)
+    const __m128i zero{_mm_setzero_si128()};
+    const __m128i one{_mm_set1_epi16(1)};
+    const __m128i cap_v{_mm_set1_epi16(cap)};
+    for (; c + 16 <= n; c += 16) {
+        const __m128i occupied{_mm_cmpgt_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(status + c)), zero)};
+        const __m128i lo{_mm_min_epi16(_mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + c)), one), cap_v)};
+        const __m128i hi{_mm_min_epi16(_mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + c + 8)), one), cap_v)};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + c), _mm_andnot_si128(_mm_unpacklo_epi8(occupied, occupied), lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + c + 8), _mm_andnot_si128(_mm_unpackhi_epi8(occupied, occupied), hi));
+    }
+#endif
+    for (; c < n; ++c) {
+        out[c] = status[c] > 0 ? 0 : std::min<int16_t>(prev[c] + 1, cap);
+    }
+}
+
+// out = min(out, next + 1), for one row
+static void sweep_backward(const int16_t* next, int16_t* out, int n)
+{
+    int c{0};
+#if defined(__SSE2__)
+    const __m128i one{_mm_set1_epi16(1)};
+    for (; c + 8 <= n; c += 8) {
+        const __m128i from_next{_mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(next + c)), one)};
+        const __m128i cur{_mm_loadu_si128(reinterpret_cast<const __m128i*>(out + c))};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + c), _mm_min_epi16(cur, from_next));
+    }
+#endif
+    for (; c < n; ++c) {
+        out[c] = std::min<int16_t>(out[c], next[c] + 1);
+    }
+}
+
+Costmap::Costmap(const DenseMap& map, const CostmapConfig& cfg, tp::ThreadPool* pool)
+    : map_(map)
+    , cfg_(cfg)
+    , pool_(pool)
+    , x_res_((map.x_range[1] - map.x_range[0]) / map.row)
+    , y_res_((map.y_range[1] - map.y_range[0]) / map.col)
+{
+    assert(cfg_.max_distance > 0.0f);
+    assert(cfg_.inflation_radius <= cfg_.max_distance);
+
+    // one past the last row / column a distance up to max_distance can come from
+    row_cap_ = static_cast<int16_t>(std::min(32766.0f, std::ceil(cfg_.max_distance / x_res_) + 1.0f));
+    col_cap_ = static_cast<int>(std::ceil(cfg_.max_distance / y_res_)) + 1;
+
+    const size_t num_cells{static_cast<size_t>(map_.row) * map_.col};
+    vertical_.resize(num_cells);
+    cap_row_.assign(map_.col, row_cap_);
+    distance_.resize(num_cells);
+    cost_.resize(num_cells);
+
+    // up to max_distance, so any clamped distance indexes it
+    lut_step_ = std::min(x_res_, y_res_) / LUT_STEPS_PER_CELL;
+    const int lut_size{static_cast<int>(cfg_.max_distance / lut_step_) + 2};
+    cost_lut_.resize(lut_size);
+    for (int i = 0; i < lut_size; ++i) {
+        const float d{i * lut_step_};
+        if (d <= cfg_.inscribed_radius) {
+            cost_lut_[i] = COST_INSCRIBED;
+        } else if (d < cfg_.inflation_radius) {
+            cost_lut_[i] = static_cast<uint8_t>((COST_INSCRIBED - 1) * std::exp(-cfg_.cost_scaling * (d - cfg_.inscribed_radius)));
+        } else {
+            cost_lut_[i] = 0;
+        }
+    }
+
+    envelopes_.resize(pool_ != nullptr ? pool_->size() : 1);
+    for (auto& env : envelopes_) {
+        env.v.resize(map_.col);
+        env.z.resize(map_.col + 1);
+        env.f.resize(map_.col);
+    }
+
+    update();
+}
+
+void Costmap::update()
+{
+    update(0, map_.row, 0, map_.col);
+}
+
+void Costmap::update(int row_begin, int row_end, int col_begin, int col_end)
+{
+    INSTR_SCOPE("costmap.update");
+    row_begin = std::max(0, row_begin);
+    col_begin = std::max(0, col_begin);
+    row_end = std::min(map_.row, row_end);
+    col_end = std::min(map_.col, col_end);
+    if (row_begin >= row_end || col_begin >= col_end) return;
+
+    // vertical distances change only in the changed columns, within row_cap_ rows
+    const int band_begin{std::max(0, row_begin - row_cap_)};
+    const int band_end{std::min(map_.row, row_end + row_cap_)};
+    vertical_pass(band_begin, band_end, col_begin, col_end);
+
+    // distances change within col_cap_ columns of the changed ones and come
+    // from parabolas within col_cap_ columns of those
+    const int out_begin{std::max(0, col_begin - col_cap_)};
+    const int out_end{std::min(map_.col, col_end + col_cap_)};
+    const int window_begin{std::max(0, out_begin - col_cap_)};
+    const int window_end{std::min(map_.col, out_end + col_cap_)};
+    auto rows = [&](int begin, int end, int worker) {
+        for (int r = band_begin + begin; r < band_begin + end; ++r) {
+            row_pass(r, window_begin, window_end, out_begin, out_end, worker);
+        }
+    };
+    const int num_rows{band_end - band_begin};
+    if (pool_ == nullptr) {
+        rows(0, num_rows, 0);
+    } else {
+        pool_->parallel_for(num_rows, std::max(16, num_rows / (pool_->size() * 4)), rows);
+    }
+}
+
+void Costmap::vertical_pass(int row_begin, int row_end, int col_begin, int col_end)
+{
+    INSTR_SCOPE("costmap.vertical_pass");
+    const int col{map_.col};
+    // rows next to the band keep their values and seed both sweeps
+    auto columns = [&](int begin, int end, int) {
+        const int c0{col_begin + begin};
+        const int n{end - begin};
+        const int16_t* prev{row_begin > 0 ? &vertical_[static_cast<size_t>(row_begin - 1) * col + c0] : &cap_row_[c0]};
+        for (int r = row_begin; r < row_end; ++r) {
+            int16_t* out{&vertical_[static_cast<size_t>(r) * col + c0]};
+            sweep_forward(&map_.grid_status[static_cast<size_t>(r) * col + c0], prev, out, n, row_cap_);
+            prev = out;
+        }
+        const int16_t* next{row_end < map_.row ? &vertical_[static_cast<size_t>(row_end) * col + c0] : &cap_row_[c0]};
+        for (int r = row_end - 1; r >= row_begin; --r) {
+            int16_t* out{&vertical_[static_cast<size_t>(r) * col + c0]};
+            sweep_backward(next, out, n);
+            next = out;
+        }
+    };
+    const int num_cols{col_end - col_begin};
+    if (pool_ == nullptr) {
+        columns(0, num_cols, 0);
+    } else {
+        // whole cache lines per task
+        const int grain{std::max(64, (num_cols / (pool_->size() * 4) + 63) & ~63)};
+        pool_->parallel_for(num_cols, grain, columns);
+    }
+}
+
+// lower envelope of the parabolas (c - q)^2 + f(q) over the window, in
+// columns, f being the vertical distance squared in the same unit
+void Costmap::row_pass(int r, int window_begin, int window_end, int col_begin, int col_end, int worker)
+{
+    const size_t offset{static_cast<size_t>(r) * map_.col};
+    const int16_t* vertical{&vertical_[offset]};
+    auto& env{envelopes_[worker]};
+    int* v{env.v.data()};
+    float* z{env.z.data()};
+    float* f{env.f.data()};
+    const float scale{x_res_ / y_res_};
+
+    int k{-1};
+    for (int q = window_begin; q < window_end; ++q) {
+        // columns with nothing within max_distance only add clamped values
+        if (vertical[q] >= row_cap_) continue;
+        const float fq{pow2(vertical[q] * scale)};
+        f[q] = fq;
+        // intersection with the last parabola, written to keep the operands small
+        float s{-INFINITY};
+        while (k >= 0) {
+            s = (fq - f[v[k]]) / (2.0f * (q - v[k])) + 0.5f * (q + v[k]);
+            if (s > z[k]) break;
+            --k;
+        }
+        if (k < 0) s = -INFINITY;
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INFINITY;
+    }
+
+    float* distance{&distance_[offset]};
+    uint8_t* cost{&cost_[offset]};
+    if (k < 0) {
+        std::fill(distance + col_begin, distance + col_end, cfg_.max_distance);
+        std::fill(cost + col_begin, cost + col_end, 0);
+        return;
+    }
+
+    const int8_t* status{&map_.grid_status[offset]};
+    const float max_d2{pow2(cfg_.max_distance / y_res_)};
+    const float inv_step{1.0f / lut_step_};
+    int j{0};
+    for (int c = col_begin; c < col_end; ++c) {
+        while (z[j + 1] < c) ++j;
+        const float d2{pow2(static_cast<float>(c - v[j])) + f[v[j]]};
+        const float d{d2 < max_d2 ? std::sqrt(d2) * y_res_ : cfg_.max_distance};
+        distance[c] = d;
+        const uint8_t inflated{cost_lut_[static_cast<int>(d * inv_step)]};
+        cost[c] = status[c] > 0 ? COST_LETHAL : inflated;
+    }
+}
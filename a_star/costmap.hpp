@@ -0,0 +1,86 @@
+#ifndef A_STAR_COSTMAP_H_
+#define A_STAR_COSTMAP_H_
+
+#include <cstdint>
+#include <vector>
+#include "map_gen.hpp"
+#include "thread_pool.hpp"
+
+#define COST_LETHAL     254     // occupied cell
+#define COST_INSCRIBED  253     // within the inscribed radius of an occupied cell
+
+struct CostmapConfig
+{
+    float max_distance;     // meter, distances are exact up to here and clamped to it above
+    float inscribed_radius; // meter
+    float inflation_radius; // meter, no cost from here on, at most max_distance
+    float cost_scaling;     // 1/meter, decay of the cost past the inscribed radius
+}; // struct CostmapConfig
+
+// Distance and inflation layers over a DenseMap, indexed like grid_status.
+// The distance to the nearest occupied cell center is the exact Euclidean
+// one (Felzenszwalb & Huttenlocher): a vertical pass over whole rows at a
+// time in SIMD, split across the pool by columns, then the lower envelope
+// of parabolas along every row, split across the pool by rows.
+class Costmap
+{
+public:
+    // the pool runs both passes when one is given, either way the executable
+    // provides THREAD_POOL_IMPLEMENTATION
+    Costmap(const DenseMap& map, const CostmapConfig& cfg, tp::ThreadPool* pool = nullptr);
+    ~Costmap() = default;
+    Costmap(const Costmap&) = delete;
+    Costmap& operator=(const Costmap&) = delete;
+
+    // recompute both layers over the whole map
+    void update();
+    // recompute only what cells [row_begin, row_end) x [col_begin, col_end)
+    // of the map can reach, after changing them
+    void update(int row_begin, int row_end, int col_begin, int col_end);
+
+    // meter, 0 outside the map
+    inline float distance(float x, float y) const
+    {
+        const int idx{grid_index(map_, x, y)};
+        return idx < 0 ? 0.0f : distance_[idx];
+    }
+    // COST_LETHAL outside the map
+    inline uint8_t cost(float x, float y) const
+    {
+        const int idx{grid_index(map_, x, y)};
+        return idx < 0 ? COST_LETHAL : cost_[idx];
+    }
+    inline const std::vector<float>& distances() const { return distance_; }
+    inline const std::vector<uint8_t>& costs() const { return cost_; }
+    inline const DenseMap& map() const { return map_; }
+    inline const CostmapConfig& config() const { return cfg_; }
+private:
+    void vertical_pass(int row_begin, int row_end, int col_begin, int col_end);
+    void row_pass(int r, int window_begin, int window_end, int col_begin, int col_end, int worker);
+
+    const DenseMap& map_;
+    CostmapConfig cfg_;
+    tp::ThreadPool* pool_;
+    float x_res_;           // meter, along rows
+    float y_res_;           // meter, along columns
+    int16_t row_cap_;       // rows past max_distance
+    int col_cap_;           // columns past max_distance
+
+    std::vector<int16_t> vertical_;     // rows to the nearest occupied cell of the column, at most row_cap_
+    std::vector<int16_t> cap_row_;      // row_cap_ everywhere, stands in for the rows off the map
+    std::vector<float> distance_;       // meter
+    std::vector<uint8_t> cost_;
+    std::vector<uint8_t> cost_lut_;     // cost of a free cell by distance / lut_step_
+    float lut_step_;                    // meter
+
+    // lower envelope scratch, one per worker
+    struct Envelope
+    {
+        std::vector<int> v;         // columns of the parabolas
+        std::vector<float> z;       // boundaries between them
+        std::vector<float> f;       // value of the parabola at its column
+    }; // struct Envelope
+    std::vector<Envelope> envelopes_;
+}; // class Costmap
+
+#endif // A_STAR_COSTMAP_H_
@@ -0,0 +1,299 @@
+#include "hierarchical_planner.hpp"
+#include <algorithm>
+#include <cmath>
+#include "instrument.hpp"
+
+#define OCCUPIED_PENALTY    10.0f   // corridor cells blocked on the guide level cost this much more
+
+
+// first level whose cells are at least `cell` wide, or the one that
+// shrinks the map to a single cell
+static int level_for(const DenseMap& map, float cell)
+{
+    const float x_res{(map.x_range[1] - map.x_range[0]) / map.row};
+    const float y_res{(map.y_range[1] - map.y_range[0]) / map.col};
+    int k{1};
+    while (std::min(x_res, y_res) * (1 << k) < cell
+        && ((map.row - 1) >> k) + ((map.col - 1) >> k) > 0) {
+        ++k;
+    }
+    return k;
+}
+
+OccupancyPyramid::OccupancyPyramid(const DenseMap& map, int num_levels)
+{
+    levels_.reserve(num_levels);
+    const float x_res{(map.x_range[1] - map.x_range[0]) / map.row};
+    const float y_res{(map.y_range[1] - map.y_range[0]) / map.col};
+
+    // level 1 straight from the map
+    Level first{
+        .nx=(map.row + 1) / 2,
+        .ny=(map.col + 1) / 2,
+        .cell_x=2.0f * x_res,
+        .cell_y=2.0f * y_res,
+        .occupied={}
+    };
+    first.occupied.assign(static_cast<size_t>(first.nx) * first.ny, 0);
+    // rows of DenseMap run down x and columns down y, so this is a transpose:
+    // blocks of row pairs are pooled into a small buffer that is written out
+    // one contiguous run per iy
+    constexpr int block{64};
+    std::vector<uint8_t> pooled(static_cast<size_t>(first.ny) * block);
+    for (int ix0 = 0; ix0 < first.nx; ix0 += block) {
+        const int n{std::min(block, first.nx - ix0)};
+        std::fill(pooled.begin(), pooled.end(), 0);
+        for (int b = 0; b < n; ++b) {
+            const int r{map.row - 1 - 2 * (ix0 + b)};
+            const int8_t* status{&map.grid_status[static_cast<size_t>(r) * map.col]};
+            const int8_t* above{r > 0 ? status - map.col : status};
+            for (int c = 0; c < map.col; ++c) {
+                pooled[((map.col - 1 - c) >> 1) * block + b] |= (status[c] > 0) | (above[c] > 0);
+            }
+        }
+        for (int iy = 0; iy < first.ny; ++iy) {
+            std::copy(&pooled[iy * block], &pooled[iy * block] + n, &first.occupied[static_cast<size_t>(iy) * first.nx + ix0]);
+        }
+    }
+    levels_.push_back(std::move(first));
+
+    for (int k = 2; k <= num_levels; ++k) {
+        const Level& prev{levels_.back()};
+        Level next{
+            .nx=(prev.nx + 1) / 2,
+            .ny=(prev.ny + 1) / 2,
+            .cell_x=2.0f * prev.cell_x,
+            .cell_y=2.0f * prev.cell_y,
+            .occupied={}
+        };
+        next.occupied.assign(static_cast<size_t>(next.nx) * next.ny, 0);
+        for (int iy = 0; iy < prev.ny; ++iy) {
+            const uint8_t* occupied{&prev.occupied[static_cast<size_t>(iy) * prev.nx]};
+            uint8_t* dst{&next.occupied[static_cast<size_t>(iy >> 1) * next.nx]};
+            for (int ix = 0; ix < prev.nx; ++ix) {
+                dst[ix >> 1] |= occupied[ix];
+            }
+        }
+        levels_.push_back(std::move(next));
+    }
+}
+
+HierarchicalPlanner::HierarchicalPlanner(const DenseMap& map, const HierarchicalConfig& cfg)
+    : map_(map)
+    , cfg_(cfg)
+    , pyramid_(map, level_for(map, std::max(cfg.coarse_cell, cfg.guide_cell)))
+    , first_level_(level_for(map, cfg.coarse_cell))
+    , guide_level_(level_for(map, cfg.guide_cell))
+    , query_(0)
+    , corridor_{}
+    , level_used_(-1)
+    , coarse_expansions_(0)
+    , fine_expansions_(0)
+    , path_cost_(INFINITY)
+{}
+
+bool HierarchicalPlanner::plan(const State& init, const State& goal, const integ::KinematicConfig& kin,
+    std::vector<State>& path, Arena* arena)
+{
+    INSTR_SCOPE("hierarchical.plan");
+    path.clear();
+    coarse_path_.clear();
+    level_used_ = -1;
+    coarse_expansions_ = 0;
+    fine_expansions_ = 0;
+    path_cost_ = INFINITY;
+
+    // finer levels than the guide would cost as much as a search of the map
+    for (int k = first_level_; k >= std::min(first_level_, guide_level_); --k) {
+        if (coarse_search(k, init, goal)) {
+            level_used_ = k;
+            break;
+        }
+    }
+    if (level_used_ < 0) return false;
+
+    // a corridor too tight for the vehicle gets one wider retry
+    for (int radius = cfg_.corridor_radius; radius <= 2 * cfg_.corridor_radius; radius *= 2) {
+        // the failed search is gone, so the retry reuses its memory
+        if (arena != nullptr && radius > cfg_.corridor_radius) arena->reset();
+        build_corridor(level_used_, radius, goal);
+        HybridAStar has{init, goal, kin, &map_, arena};
+        has.set_corridor(&corridor_);
+        const bool found{has.search(cfg_.max_expansions)};
+        fine_expansions_ += has.expansions();
+        if (found) {
+            has.extract_path(path);
+            path_cost_ = has.path_cost();
+            return true;
+        }
+        if (radius == 0) break;
+    }
+    return false;
+}
+
+bool HierarchicalPlanner::coarse_search(int k, const State& init, const State& goal)
+{
+    INSTR_SCOPE("hierarchical.coarse_search");
+    const auto& level{pyramid_.level(k)};
+    auto cell_of = [&](const State& s) {
+        const int ix{static_cast<int>(std::floor((s.x - map_.x_range[0]) / level.cell_x))};
+        const int iy{static_cast<int>(std::floor((s.y - map_.y_range[0]) / level.cell_y))};
+        if (ix < 0 || iy < 0 || ix >= level.nx || iy >= level.ny) return -1;
+        return iy * level.nx + ix;
+    };
+    const int start{cell_of(init)};
+    const int target{cell_of(goal)};
+    if (start < 0 || target < 0) return false;
+
+    const size_t num_cells{static_cast<size_t>(level.nx) * level.ny};
+    if (stamp_.size() < num_cells) {
+        stamp_.resize(num_cells, 0);
+        g_.resize(num_cells);
+        parent_.resize(num_cells);
+    }
+    if (++query_ == 0) {
+        std::fill(stamp_.begin(), stamp_.end(), 0);
+        query_ = 1;
+    }
+
+    const int tx{target % level.nx};
+    const int ty{target / level.nx};
+    const float diag{std::hypot(level.cell_x, level.cell_y)};
+    // octile distance in meters
+    auto heuristic = [&](int i) {
+        const float dx{std::abs(i % level.nx - tx) * level.cell_x};
+        const float dy{std::abs(i / level.nx - ty) * level.cell_y};
+        return std::max(dx, dy) + static_cast<float>(M_SQRT2 - 1.0) * std::min(dx, dy);
+    };
+    // init and goal may sit in a blocked coarse cell, a free corner of it is enough
+    auto blocked = [&](int i) { return level.occupied[i] && i != start && i != target; };
+
+    PriorityQueue<OpenEntry> open;
+    stamp_[start] = query_;
+    g_[start] = 0.0f;
+    parent_[start] = -1;
+    open.enque({.cost=heuristic(start), .node=static_cast<uint32_t>(start)});
+    while (!open.empty()) {
+        const auto entry{open.top()};
+        open.deque();
+        const int current{static_cast<int>(entry.node)};
+        // stale entry of a cell reached cheaper later
+        if (entry.cost > g_[current] + heuristic(current) + 1.0e-3f) continue;
+        ++coarse_expansions_;
+        if (current == target) {
+            for (int i = target; i >= 0; i = parent_[i]) {
+                coarse_path_.push_back(i);
+            }
+            std::reverse(coarse_path_.begin(), coarse_path_.end());
+            return true;
+        }
+
+        const int cx{current % level.nx};
+        const int cy{current / level.nx};
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dx == 0 && dy == 0) continue;
+                const int nx{cx + dx};
+                const int ny{cy + dy};
+                if (nx < 0 || ny < 0 || nx >= level.nx || ny >= level.ny) continue;
+                const int next{ny * level.nx + nx};
+                if (blocked(next)) continue;
+                // no cutting corners between two blocked cells
+                if (dx != 0 && dy != 0 && (blocked(cy * level.nx + nx) || blocked(ny * level.nx + cx))) {
+                    continue;
+                }
+                const float step{dx == 0 ? level.cell_y : dy == 0 ? level.cell_x : diag};
+                const float g{g_[current] + step};
+                if (stamp_[next] == query_ && g >= g_[next]) continue;
+                stamp_[next] = query_;
+                g_[next] = g;
+                parent_[next] = current;
+                open.enque({.cost=g + heuristic(next), .node=static_cast<uint32_t>(next)});
+            }
+        }
+    }
+    return false;
+}
+
+void HierarchicalPlanner::build_corridor(int k, int radius, const State& goal)
+{
+    INSTR_SCOPE("hierarchical.build_corridor");
+    const auto& coarse{pyramid_.level(k)};
+    int min_x{coarse.nx};
+    int min_y{coarse.ny};
+    int max_x{0};
+    int max_y{0};
+    for (const int i : coarse_path_) {
+        min_x = std::min(min_x, i % coarse.nx);
+        max_x = std::max(max_x, i % coarse.nx);
+        min_y = std::min(min_y, i / coarse.nx);
+        max_y = std::max(max_y, i / coarse.nx);
+    }
+    min_x = std::max(0, min_x - radius);
+    min_y = std::max(0, min_y - radius);
+    max_x = std::min(coarse.nx - 1, max_x + radius);
+    max_y = std::min(coarse.ny - 1, max_y + radius);
+
+    // dilate the coarse path inside its bounding box
+    const int mask_nx{max_x - min_x + 1};
+    const int mask_ny{max_y - min_y + 1};
+    std::vector<uint8_t> mask(static_cast<size_t>(mask_nx) * mask_ny, 0);
+    for (const int i : coarse_path_) {
+        const int px{i % coarse.nx - min_x};
+        const int py{i / coarse.nx - min_y};
+        for (int y = std::max(0, py - radius); y <= std::min(mask_ny - 1, py + radius); ++y) {
+            std::fill(&mask[y * mask_nx + std::max(0, px - radius)],
+                &mask[y * mask_nx + std::min(mask_nx - 1, px + radius)] + 1, 1);
+        }
+    }
+
+    // the cost to go lives on the finer guide level, a cell of it is inside
+    // when the coarse cell above it is
+    const int j{std::min(guide_level_, k)};
+    const int shift{k - j};
+    const auto& guide{pyramid_.level(j)};
+    const int gx0{min_x << shift};
+    const int gy0{min_y << shift};
+    corridor_.x0 = map_.x_range[0] + gx0 * guide.cell_x;
+    corridor_.y0 = map_.y_range[0] + gy0 * guide.cell_y;
+    corridor_.cell_x = guide.cell_x;
+    corridor_.cell_y = guide.cell_y;
+    corridor_.nx = std::min(guide.nx, (max_x + 1) << shift) - gx0;
+    corridor_.ny = std::min(guide.ny, (max_y + 1) << shift) - gy0;
+    const int nx{corridor_.nx};
+    const int ny{corridor_.ny};
+    auto& cost{corridor_.cost_to_go};
+    cost.assign(static_cast<size_t>(nx) * ny, INFINITY);
+    auto inside = [&](int x, int y) { return mask[(y >> shift) * mask_nx + (x >> shift)] != 0; };
+    auto occupied = [&](int x, int y) { return guide.occupied[(y + gy0) * guide.nx + x + gx0] != 0; };
+
+    // meters to the goal over the corridor, blocked guide cells stay reachable
+    // at a penalty so that every cell inside has a finite cost
+    const int goal_cell{corridor_.index(goal.x, goal.y)};
+    if (goal_cell < 0) return;
+    const float diag{std::hypot(guide.cell_x, guide.cell_y)};
+    PriorityQueue<OpenEntry> open;
+    cost[goal_cell] = 0.0f;
+    open.enque({.cost=0.0f, .node=static_cast<uint32_t>(goal_cell)});
+    while (!open.empty()) {
+        const auto entry{open.top()};
+        open.deque();
+        const int current{static_cast<int>(entry.node)};
+        if (entry.cost > cost[current]) continue;
+        const int cx{current % nx};
+        const int cy{current / nx};
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dx == 0 && dy == 0) continue;
+                const int x{cx + dx};
+                const int y{cy + dy};
+                if (x < 0 || y < 0 || x >= nx || y >= ny || !inside(x, y)) continue;
+                const float step{dx == 0 ? guide.cell_y : dy == 0 ? guide.cell_x : diag};
+                const float c{entry.cost + step * (occupied(x, y) ? OCCUPIED_PENALTY : 1.0f)};
+                if (c >= cost[y * nx + x]) continue;
+                cost[y * nx + x] = c;
+                open.enque({.cost=c, .node=static_cast<uint32_t>(y * nx + x)});
+            }
+        }
+    }
+}
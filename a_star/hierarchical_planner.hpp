@@ -0,0 +1,98 @@
+#ifndef A_STAR_HIERARCHICAL_PLANNER_H_
+#define A_STAR_HIERARCHICAL_PLANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "arena.hpp"
+#include "corridor.hpp"
+#include "hybrid_a_star.hpp"
+#include "integrator.hpp"
+#include "map_gen.hpp"
+
+// Max-pooled copies of a DenseMap: a cell of level k is occupied if any of
+// the 2^k x 2^k map cells under it is. Level 0 is the map itself and is
+// not copied. Cells are indexed iy * nx + ix with x and y growing from the
+// map origin, unlike DenseMap.
+class OccupancyPyramid
+{
+public:
+    struct Level
+    {
+        int nx;
+        int ny;
+        float cell_x;       // meter
+        float cell_y;       // meter
+        std::vector<uint8_t> occupied;
+    }; // struct Level
+
+    // levels 1 to num_levels, each halves the previous one
+    OccupancyPyramid(const DenseMap& map, int num_levels);
+    ~OccupancyPyramid() = default;
+
+    inline const Level& level(int k) const { return levels_[k - 1]; }
+    inline int num_levels() const { return static_cast<int>(levels_.size()); }
+private:
+    std::vector<Level> levels_;
+}; // class OccupancyPyramid
+
+struct HierarchicalConfig
+{
+    float coarse_cell;      // meter, the coarse search runs on the first level at least this coarse
+    float guide_cell;       // meter, same for the corridor cost to go, finer than coarse_cell
+    int corridor_radius;    // coarse cells kept around the coarse path
+    size_t max_expansions;  // fine search
+}; // struct HierarchicalConfig
+
+// 8-connected A* on a pyramid level finds a corridor of coarse cells, the
+// fine HybridAStar search is then restricted to it and guided by a cost to
+// go computed on a finer level inside it. Per query work follows the path
+// length, only the pyramid is built over the whole map, once. A level with
+// no coarse path falls back to the next finer one, down to the guide level.
+class HierarchicalPlanner
+{
+public:
+    HierarchicalPlanner(const DenseMap& map, const HierarchicalConfig& cfg);
+    ~HierarchicalPlanner() = default;
+    HierarchicalPlanner(const HierarchicalPlanner&) = delete;
+    HierarchicalPlanner& operator=(const HierarchicalPlanner&) = delete;
+
+    // the fine search allocates from the arena when one is given, a retry
+    // with a wider corridor resets it first
+    bool plan(const State& init, const State& goal, const integ::KinematicConfig& kin,
+        std::vector<State>& path, Arena* arena = nullptr);
+
+    inline const OccupancyPyramid& pyramid() const { return pyramid_; }
+    inline const Corridor& corridor() const { return corridor_; }
+    // coarse cells from init to the goal of the last query, iy * nx + ix on coarse_level()
+    inline const std::vector<int>& coarse_path() const { return coarse_path_; }
+    inline int coarse_level() const { return level_used_; }
+    inline size_t coarse_expansions() const { return coarse_expansions_; }
+    inline size_t fine_expansions() const { return fine_expansions_; }
+    inline float path_cost() const { return path_cost_; }
+private:
+    bool coarse_search(int k, const State& init, const State& goal);
+    void build_corridor(int k, int radius, const State& goal);
+
+    const DenseMap& map_;
+    HierarchicalConfig cfg_;
+    OccupancyPyramid pyramid_;
+    int first_level_;
+    int guide_level_;
+
+    // coarse search scratch, sized to the largest level searched and
+    // invalidated by bumping the stamp instead of clearing
+    std::vector<uint32_t> stamp_;
+    std::vector<float> g_;
+    std::vector<int32_t> parent_;
+    uint32_t query_;
+
+    Corridor corridor_;
+    std::vector<int> coarse_path_;
+    int level_used_;
+    size_t coarse_expansions_;
+    size_t fine_expansions_;
+    float path_cost_;
+}; // class HierarchicalPlanner
+
+#endif // A_STAR_HIERARCHICAL_PLANNER_H_
@@ -0,0 +1,160 @@
+#include "hybrid_a_star.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "instrument.hpp"
+
+#define RS_PATH_IMPLEMENTATION
+#include "rspath.h"
+
+#define ROBOT_TURN_RADIUS 3.0f
+#define CLOSED_XY_RES     0.3f    // meter
+#define CLOSED_YAW_BINS   72
+
+HybridAStar::HybridAStar(const State& init, const State& goal, const integ::KinematicConfig& kin,
+    const DenseMap* map, Arena* arena)
+    : pq(ArenaAllocator<OpenEntry>{arena})
+    , nodes_(arena)
+    , closed_(arena)
+    , init_(init)
+    , goal_(goal)
+    , kin_(kin)
+    , map_(map)
+    , arena_(arena)
+    , viz_(nullptr)
+    , corridor_(nullptr)
+    , expansions_(0)
+    , goal_node_(-1)
+{}
+
+bool HybridAStar::search(size_t max_expansions)
+{
+    constexpr float short_distance{0.5f}; // meter
+
+    INSTR_SCOPE("hybrid_a_star.search");
+    if (collides(init_)) return false;
+
+    std::vector<State, ArenaAllocator<State>> neighbors{ArenaAllocator<State>{arena_}};
+    pq.enque({.cost=0.0f, .node=nodes_.push({.state=init_, .parent=-1, .g=0.0f})});
+    INSTR_COUNT(instr::CNT_QUEUE_PUSHES);
+    while (!pq.empty() && expansions_ < max_expansions) {
+        const uint32_t current_node{pq.top().node};
+        pq.deque();
+        INSTR_COUNT(instr::CNT_QUEUE_POPS);
+        // chunks never move, the reference survives the pushes below
+        const Node& current{nodes_[current_node]};
+        if (!closed_.insert(closed_key(current.state))) {
+            continue;
+        }
+
+        ++expansions_;
+        INSTR_COUNT(instr::CNT_EXPANSIONS);
+        VIZ_DRAW(viz_, point(viz::LAYER_EXPANSION, current.state.x, current.state.y));
+        if (euclidean_dist(current.state, goal_) < short_distance) {
+            goal_node_ = current_node;
+            return true;
+        }
+
+        find_neighbors(current.state, neighbors);
+        if (neighbors.empty()) {
+            continue;
+        }
+
+        for (size_t i = 0; i < neighbors.size(); ++i) {
+            const auto& neighbor{neighbors[i]};
+            if (collides(neighbor) || closed_.contains(closed_key(neighbor))) {
+                continue;
+            }
+            const auto this_cost{neighbor_cost(neighbor)};
+            const uint32_t node{nodes_.push({
+                .state=neighbor,
+                .parent=static_cast<int>(current_node),
+                .g=current.g + euclidean_dist(current.state, neighbor)
+            })};
+            pq.enque({.cost=this_cost, .node=node});
+            INSTR_COUNT(instr::CNT_QUEUE_PUSHES);
+        }
+    }
+
+    return false;
+}
+
+bool HybridAStar::extract_path(std::vector<State>& path) const
+{
+    if (goal_node_ < 0) return false;
+
+    path.clear();
+    for (int i = goal_node_; i >= 0; i = nodes_[i].parent) {
+        path.push_back(nodes_[i].state);
+    }
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+float HybridAStar::neighbor_cost(const State& neighbor)
+{
+    const float dist{euclidean_dist(goal_, neighbor)};
+    if (dist > 10.0f) {
+        if (corridor_ != nullptr) return corridor_->cost(neighbor.x, neighbor.y);
+        return (std::abs(neighbor.x - goal_.x) + std::abs(neighbor.y - goal_.y));
+    } else {
+        RsPath rs_path;
+        const float dx{goal_.x - neighbor.x};
+        const float dy{goal_.y - neighbor.y};
+        const float cos_yaw{std::cos(neighbor.heading)};
+        const float sin_yaw{std::sin(neighbor.heading)};
+        const float x{cos_yaw * dx + sin_yaw * dy};
+        const float y{-sin_yaw * dx + cos_yaw * dy};
+        const float phi{goal_.heading - neighbor.heading};
+        INSTR_COUNT(instr::CNT_RS_CALLS);
+        rs_find_from_all_path(x / ROBOT_TURN_RADIUS, y / ROBOT_TURN_RADIUS, phi, &rs_path);
+        return rs_path.length * ROBOT_TURN_RADIUS;
+    }
+}
+
+void HybridAStar::find_neighbors(const State& current, std::vector<State, ArenaAllocator<State>>& neighbors)
+{
+    constexpr float steer_start{-0.5f};
+    constexpr float steer_end{0.5f};
+    constexpr float steer_inc{0.1f};
+    constexpr float step_size{0.2f};
+    constexpr int move_steps{3};
+
+    neighbors.clear();
+    State search_state;
+    for (float sa = steer_start; sa < steer_end; sa += steer_inc) {
+        // every primitive is a single step from the current state
+        for (int i = 1; i <= move_steps; ++i) {
+            // forward
+            search_state = current;
+            integ::step(search_state, kin_, sa, step_size * i);
+            neighbors.push_back(search_state);
+
+            // backward
+            search_state = current;
+            integ::step(search_state, kin_, sa, -step_size * i);
+            neighbors.push_back(search_state);
+        }
+    }
+}
+
+bool HybridAStar::collides(const State& s) const
+{
+    INSTR_COUNT(instr::CNT_COLLISION_CHECKS);
+    if (corridor_ != nullptr && !corridor_->contains(s.x, s.y)) return true;
+    if (map_ == nullptr) return false;
+    const int idx{grid_index(*map_, s.x, s.y)};
+    return idx < 0 || map_->grid_status[idx] > 0;
+}
+
+uint64_t HybridAStar::closed_key(const State& s) const
+{
+    constexpr float two_pi{2.0f * static_cast<float>(M_PI)};
+    const auto ix{static_cast<int32_t>(std::floor(s.x / CLOSED_XY_RES))};
+    const auto iy{static_cast<int32_t>(std::floor(s.y / CLOSED_XY_RES))};
+    float yaw{std::fmod(s.heading, two_pi)};
+    if (yaw < 0.0f) yaw += two_pi;
+    const auto iyaw{std::min(CLOSED_YAW_BINS - 1, static_cast<int>(yaw / two_pi * CLOSED_YAW_BINS))};
+    return (static_cast<uint64_t>(ix & 0x1fffff) << 28) | (static_cast<uint64_t>(iy & 0x1fffff) << 7) |
+        static_cast<uint64_t>(iyaw);
+}
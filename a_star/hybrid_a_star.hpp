@@ -0,0 +1,160 @@
+#ifndef A_STAR_HYBRID_A_STAR_H_
+#define A_STAR_HYBRID_A_STAR_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "arena.hpp"
+#include "corridor.hpp"
+#include "integrator.hpp"
+#include "map_gen.hpp"
+#include "math_util.hpp"
+#include "node_pool.hpp"
+#include "viz_sink.hpp"
+
+#define HAS_MAX_EXPANSIONS 100000
+
+template<typename T, typename Alloc = std::allocator<T>>
+class PriorityQueue
+{
+public:
+    explicit PriorityQueue(const Alloc& alloc = Alloc())
+        : data_(alloc)
+    {}
+    ~PriorityQueue() = default;
+    void enque(const T& v);
+    void enque(T&& v);
+    void deque();
+
+    inline size_t size() { return data_.size(); }
+    inline const T& top() const { return data_[0]; }
+    inline bool empty() const { return data_.empty(); }
+private:
+    void heaped_up(size_t i);
+    void heaped_down(size_t i);
+    // inlined instead of going through a std::function on every swap
+    static inline int cmp_(const T& a, const T& b) { return a < b ? -1 : 1; }
+    std::vector<T, Alloc> data_;
+}; // class PriorityQueue
+
+
+struct State
+{
+    float x;
+    float y;
+    float heading;
+}; // struct State
+
+template<typename T, typename Alloc>
+void PriorityQueue<T, Alloc>::enque(const T& v)
+{
+    data_.push_back(v);
+    heaped_up(data_.size() - 1);
+}
+
+template<typename T, typename Alloc>
+void PriorityQueue<T, Alloc>::enque(T&& v)
+{
+    data_.push_back(std::move(v));
+    heaped_up(data_.size() - 1);
+}
+
+template<typename T, typename Alloc>
+void PriorityQueue<T, Alloc>::deque()
+{
+    if (data_.empty()) return;
+    if (data_.size() == 1) {
+        data_.pop_back();
+        return;
+    }
+
+    data_[0] = data_[data_.size() - 1];
+    data_.pop_back();
+    heaped_down(0);
+}
+
+template<typename T, typename Alloc>
+void PriorityQueue<T, Alloc>::heaped_up(size_t i)
+{
+    while (i > 0) {
+        const auto parent{(i - 1) / 2};
+        if (cmp_(data_[parent], data_[i]) <= 0) break;
+        std::swap(data_[parent], data_[i]);
+        i = parent;
+    }
+}
+
+template<typename T, typename Alloc>
+void PriorityQueue<T, Alloc>::heaped_down(size_t i)
+{
+    const auto que_size{data_.size()};
+    while (i < que_size) {
+        const auto left_child{i * 2 + 1};
+        const auto right_child{i * 2 + 2};
+        if (left_child >= que_size) break;
+        size_t min_idx{left_child};
+        if (right_child < que_size && cmp_(data_[min_idx], data_[right_child]) > 0) {
+            min_idx = right_child;
+        }
+
+        if (cmp_(data_[min_idx], data_[i]) < 0) {
+            std::swap(data_[min_idx], data_[i]);
+            i = min_idx;
+        } else {
+            break;
+        }
+    }
+}
+
+class HybridAStar
+{
+public:
+    // states on occupied cells or off the map are pruned when a map is given,
+    // every container of the search allocates from the arena when one is given
+    HybridAStar(const State& init, const State& goal, const integ::KinematicConfig& kin,
+        const DenseMap* map = nullptr, Arena* arena = nullptr);
+    ~HybridAStar() = default;
+    bool search(size_t max_expansions = HAS_MAX_EXPANSIONS);
+    // states from init to the goal, false before a successful search
+    bool extract_path(std::vector<State>& path) const;
+    // every expanded state is drawn as a point on LAYER_EXPANSION, nullptr draws nothing
+    inline void set_viz(viz::VizSink* sink) { viz_ = sink; }
+    // states outside the corridor are pruned and its cost to go replaces the
+    // distance heuristic far from the goal, nullptr searches the whole map
+    inline void set_corridor(const Corridor* corridor) { corridor_ = corridor; }
+
+    inline size_t expansions() const { return expansions_; }
+    inline size_t num_nodes() const { return nodes_.size(); }
+    inline size_t node_bytes() const { return nodes_.bytes(); }
+    // meter driven from init to the goal
+    inline float path_cost() const { return goal_node_ < 0 ? INFINITY : nodes_[goal_node_].g; }
+private:
+    void find_neighbors(const State& current, std::vector<State, ArenaAllocator<State>>& neighbors);
+    float neighbor_cost(const State& neighbor);
+    bool collides(const State& s) const;
+    uint64_t closed_key(const State& s) const;
+
+    struct Node {
+        State state;
+        int parent;
+        float g;            // meter driven from init
+    };
+
+    PriorityQueue<OpenEntry, ArenaAllocator<OpenEntry>> pq;
+    NodePool<Node> nodes_;
+    FlatKeySet closed_;
+    State init_;
+    State goal_;
+    integ::KinematicConfig kin_;
+    const DenseMap* map_;
+    Arena* arena_;
+    viz::VizSink* viz_;
+    const Corridor* corridor_;
+    size_t expansions_;
+    int goal_node_;
+}; // class HybridAStar
+
+#endif // A_STAR_HYBRID_A_STAR_H_
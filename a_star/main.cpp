@@ -1,252 +1,201 @@
 #include <algorithm>
+#include <atomic>
 #include <cmath>
-#include <cstddef>
 #include <cstdlib>
-#include <functional>
-#include <utility>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
 #include <vector>
 
-#define RS_PATH_IMPLEMENTATION
-#include "rspath.h"
+#include "hybrid_a_star.hpp"
+#include "integrator.hpp"
+#include "map_corpus.hpp"
+#include "raster.hpp"
+#include "viz_sink.hpp"
 
 #define RVIZ_IMPLEMENTATION
 #include "rviz.hpp"
+#include "viz_rviz.hpp"
 
 
-#define ROBOT_TURN_RADIUS 3.0f
+#define WHEEL_BASE        2.8f    // meter
+#define MAP_RESOLUTION    0.25f   // meter
 
-template<typename T>
-class PriorityQueue
+struct Options
 {
-public:
-    PriorityQueue() : cmp_([](const T& a, const T& b) { return a < b ? -1 : 1; }) {}
-    // explicit PriorityQueue(std::function<int(const T&, const T&)> cmp)
-    //     : cmp_(cmp) {}
-    ~PriorityQueue() = default;
-    void enque(const T& v);
-    void enque(T&& v);
-    void deque();
-
-    inline size_t size() { return data_.size(); }
-    inline const T& top() const { return data_.at(0); }
-    inline bool empty() const { return data_.empty(); }
-private:
-    void heaped_up(size_t i);
-    void heaped_down(size_t i);
-    std::function<int(const T&, const T&)> cmp_;
-    std::vector<T> data_;
-}; // class PriorityQueue
-
-
-struct State
+    const char* record;     // dump the search trace to a file instead of drawing it
+    const char* view;       // draw a dumped trace, no search
+    const char* png;        // rasterize the map, search and path to a PNG, no window
+    int png_size;           // pixel
+    int decimate;           // draw every n-th expansion
+    const char* corpus;     // map kind of map_corpus.hpp, empty space if not given
+    float map_size;         // meter
+    unsigned int seed;
+}; // struct Options
+
+bool parse_options(int argc, char** argv, Options& opts)
 {
-    float x;
-    float y;
-    float heading;
-}; // struct State
-
-template<typename T>
-inline T pow2(T v) { return v * v; }
-
-template<typename T>
-inline T pow3(T v) { return v * v * v; }
-
-inline float euclidean_dist(const State& a, const State& b)
-{
-    return std::sqrt(pow2(a.x - b.x) + pow2(a.y - b.y));
-}
-
-template<typename T>
-void PriorityQueue<T>::enque(const T& v)
-{
-    data_.push_back(v);
-    heaped_up(data_.size() - 1);
-}
-
-template<typename T>
-void PriorityQueue<T>::enque(T&& v)
-{
-    data_.push_back(std::move(v));
-    heaped_up(data_.size() - 1);
-}
-
-template<typename T>
-void PriorityQueue<T>::deque()
-{
-    if (data_.empty()) return;
-    if (data_.size() == 1) {
-        data_.pop_back();
-        return;
-    }
-
-    data_.at(0) = data_.at(data_.size() - 1);
-    data_.pop_back();
-    heaped_down(0);
-}
-
-template<typename T>
-void PriorityQueue<T>::heaped_up(size_t i)
-{
-    while (i > 0) {
-        const auto parent{(i - 1) / 2};
-        if (cmp_(data_.at(parent), data_.at(i)) > 0) {
-            std::swap(data_.at(parent), data_.at(i));
-        }
-        i = parent;
-    }
-}
-
-template<typename T>
-void PriorityQueue<T>::heaped_down(size_t i)
-{
-    const auto que_size{data_.size()};
-    while (i < que_size) {
-        const auto left_child{i * 2 + 1};
-        const auto right_child{i * 2 + 2};
-        if (left_child >= que_size) break;
-        size_t min_idx{left_child};
-        if (right_child < que_size && cmp_(data_.at(min_idx), data_.at(right_child)) > 0) {
-            min_idx = right_child;
-        }
-
-        if (cmp_(data_.at(min_idx), data_.at(i)) < 0) {
-            std::swap(data_.at(min_idx), data_.at(i));
-            i = min_idx;
+    opts = {
+        .record=nullptr,
+        .view=nullptr,
+        .png=nullptr,
+        .png_size=1024,
+        .decimate=1,
+        .corpus=nullptr,
+        .map_size=100.0f,
+        .seed=0
+    };
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--record") == 0 && has_value) {
+            opts.record = argv[++i];
+        } else if (std::strcmp(argv[i], "--view") == 0 && has_value) {
+            opts.view = argv[++i];
+        } else if (std::strcmp(argv[i], "--png") == 0 && has_value) {
+            opts.png = argv[++i];
+        } else if (std::strcmp(argv[i], "--png-size") == 0 && has_value) {
+            opts.png_size = std::max(16, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--decimate") == 0 && has_value) {
+            opts.decimate = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--corpus") == 0 && has_value) {
+            opts.corpus = argv[++i];
+        } else if (std::strcmp(argv[i], "--map-size") == 0 && has_value) {
+            opts.map_size = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            opts.seed = std::strtoul(argv[++i], nullptr, 10);
         } else {
-            break;
+            return false;
         }
     }
+    return opts.map_size > 0.0f;
 }
 
-class HybridAStar
-{
-public:
-    HybridAStar(const State& init, const State& goal);
-    ~HybridAStar() = default;
-    bool search();
-private:
-    void find_neighbors(const State& current, std::vector<State>& neighbors);
-    float neighbor_cost(const State& neighbor);
-    void kinematic_model(State& state, float steer_angle, float moves);
-
-    struct StateCost {
-        State state;
-        float cost;
-        bool operator<(const StateCost& other) const { return cost < other.cost ? true : false; }
-    };
-
-    PriorityQueue<StateCost> pq;
-    State init_;
-    State goal_;
-}; // class HybridAStar
-
-HybridAStar::HybridAStar(const State& init, const State& goal)
-    : init_(init)
-    , goal_(goal)
-{}
-
-bool HybridAStar::search()
+// draws a dumped trace in the window, or into a PNG when `png` is given
+int view(const char* path, const char* png, int png_size)
 {
-    constexpr float short_distance{0.5f}; // meter
-
-    std::vector<State> neighbors;
-    auto viz{rviz::Viz::instance()};
-
-    pq.enque({.state=init_, .cost=0.0f});
-    while (!pq.empty()) {
-        const auto current{pq.top().state};
-        pq.deque();
-        viz->draw_trj2d_point_("test/trj", current.x, current.y);
-        if (euclidean_dist(current, goal_) < short_distance) {
-            break;
-        }
-
-        find_neighbors(current, neighbors);
-        if (neighbors.empty()) {
-            continue;
+    std::vector<viz::DrawCmd> cmds;
+    if (!viz::read_viz_file(path, cmds)) {
+        std::cerr << "Read trace " << path << " failed\n";
+        return 1;
+    }
+    if (png != nullptr) {
+        raster::Rasterizer rast;
+        for (const auto& cmd : cmds) {
+            rast.draw(cmd);
         }
-
-        for (size_t i = 0; i < neighbors.size(); ++i) {
-            const auto& neighbor{neighbors.at(i)};
-            const auto this_cost{neighbor_cost(neighbor)};
-            pq.enque({.state=neighbor, .cost=this_cost});
+        raster::Canvas canvas{png_size, png_size};
+        rast.fit(canvas);
+        rast.render(canvas);
+        if (!canvas.write_png(png)) {
+            std::cerr << "Write " << png << " failed\n";
+            return 1;
         }
+        return 0;
     }
 
-    return true;
+    auto v{rviz::Viz::instance()};
+    for (const auto& cmd : cmds) {
+        viz::draw_rviz(v, cmd);
+    }
+    RVIZ_RENDER_UNTIL_CLOSED();
+    return 0;
 }
 
-float HybridAStar::neighbor_cost(const State& neighbor)
+// search, then send the path after the expansions
+bool plan(HybridAStar& has, viz::VizSink& sink)
 {
-    const float dist{euclidean_dist(goal_, neighbor)};
-    if (dist > 10.0f) {
-        return (std::abs(neighbor.x - goal_.x) + std::abs(neighbor.y - goal_.y));
-    } else {
-        RsPath rs_path;
-        const float dx{goal_.x - neighbor.x};
-        const float dy{goal_.y - neighbor.y};
-        const float cos_yaw{std::cos(neighbor.heading)};
-        const float sin_yaw{std::sin(neighbor.heading)};
-        const float x{cos_yaw * dx + sin_yaw * dy};
-        const float y{-sin_yaw * dx + cos_yaw * dy};
-        const float phi{goal_.heading - neighbor.heading};
-        rs_find_from_all_path(x / ROBOT_TURN_RADIUS, y / ROBOT_TURN_RADIUS, phi, &rs_path);
-        return rs_path.length * ROBOT_TURN_RADIUS;
+    has.set_viz(&sink);
+    if (!has.search()) {
+        std::cerr << "Search path with HybridAStar failed\n";
+        return false;
     }
+    std::vector<State> path;
+    has.extract_path(path);
+    for (const auto& s : path) {
+        sink.point(viz::LAYER_PATH, s.x, s.y);
+    }
+    std::cout << "expansions: " << has.expansions() << ", path: " << has.path_cost() << " m\n";
+    return true;
 }
 
-void HybridAStar::find_neighbors(const State& current, std::vector<State>& neighbors)
+int main(int argc, char** argv)
 {
-    constexpr float steer_start{-0.5f};
-    constexpr float steer_end{0.5f};
-    constexpr float steer_inc{0.1f};
-    constexpr float step_size{0.2f};
-    constexpr int move_steps{3};
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::cerr << "usage: " << argv[0] << " [--record FILE | --view FILE | --png FILE [--png-size PIXEL]]"
+                  << " [--decimate N] [--corpus KIND [--map-size METER] [--seed N]]\n";
+        return 1;
+    }
+    if (opts.view != nullptr) {
+        return view(opts.view, opts.png, opts.png_size);
+    }
 
-    neighbors.clear();
-    State search_state;
-    for (float sa = steer_start; sa < steer_end; sa += steer_inc) {
-        // forward
-        search_state = current;
-        kinematic_model(search_state, sa, 0);
-        for (int i = 0; i < move_steps; ++i) {
-            kinematic_model(search_state, sa, step_size * i);
-            neighbors.push_back(search_state);
+    State init{.x=0.0f, .y=0.0f, .heading=0.0f};
+    State goal{.x=10.0f, .y=10.0f, .heading=M_PI_2};
+    CorpusMap cm;
+    const DenseMap* map{nullptr};
+    if (opts.corpus != nullptr) {
+        MapKind kind;
+        if (!parse_map_kind(opts.corpus, kind)) {
+            std::cerr << "Unknown map kind " << opts.corpus << "\n";
+            return 1;
         }
-
-        // backward
-        search_state = current;
-        kinematic_model(search_state, sa, 0);
-        for (int i = 0; i < move_steps; ++i) {
-            kinematic_model(search_state, sa, -step_size * i);
-            neighbors.push_back(search_state);
+        if (!make_corpus_map(kind, opts.map_size, MAP_RESOLUTION, opts.seed, cm)) {
+            std::cerr << "No free start / goal on " << opts.corpus << " map " << opts.seed << "\n";
+            return 1;
         }
+        init = {.x=cm.start.x, .y=cm.start.y, .heading=cm.start.heading};
+        goal = {.x=cm.goal.x, .y=cm.goal.y, .heading=cm.goal.heading};
+        map = &cm.map;
+    }
+    const integ::KinematicConfig kin{.wheel_base=WHEEL_BASE, .method=integ::INTEG_ARC, .tolerance=1.0e-3f};
+    HybridAStar has{init, goal, kin, map};
+
+    if (opts.record != nullptr) {
+        viz::FileSink sink;
+        if (!sink.open(opts.record)) {
+            std::cerr << "Open trace " << opts.record << " failed\n";
+            return 1;
+        }
+        const bool found{plan(has, sink)};
+        std::cout << sink.count() << " draw commands written to " << opts.record << "\n";
+        return found ? 0 : 1;
     }
-}
-
-void HybridAStar::kinematic_model(State& state, float steer_angle, float moves)
-{
-    constexpr float wheel_base{2.8f};   // meter
 
-    const float r{wheel_base / std::tan(steer_angle)};
-    const float yaw_gain{moves / r};
-    state.heading += yaw_gain;
-    const float x_gain{moves * std::cos(state.heading)};
-    const float y_gain{moves * std::sin(state.heading)};
-    state.x += x_gain;
-    state.y += y_gain;
-}
+    if (opts.png != nullptr) {
+        raster::Rasterizer rast;
+        const bool found{plan(has, rast)};
+        raster::Canvas canvas{opts.png_size, opts.png_size};
+        if (map != nullptr) {
+            canvas.set_view(map->x_range[0], map->y_range[0], map->x_range[1], map->y_range[1]);
+            raster::draw_occupancy(canvas, *map);
+        } else {
+            rast.fit(canvas);
+        }
+        rast.render(canvas);
+        if (!canvas.write_png(opts.png)) {
+            std::cerr << "Write " << opts.png << " failed\n";
+            return 1;
+        }
+        return found ? 0 : 1;
+    }
 
-int main()
-{
-    auto viz{rviz::Viz::instance()};
-    State init{.x=0.0f, .y=0.0f, .heading=0.0f};
-    State goal{.x=10.0f, .y=10.0f, .heading=M_PI_2};
-    HybridAStar has{init, goal};
-    has.search();
+    // the search runs at full speed on its own thread, this one only renders
+    auto v{rviz::Viz::instance()};
+    viz::QueueSink sink{1 << 16, opts.decimate};
+    std::atomic<bool> found{false};
+    std::thread planner{[&]() { found = plan(has, sink); }};
 
-    while (!viz->closed()) {
-        viz->render();
+    auto draw = [v](const viz::DrawCmd& cmd) { viz::draw_rviz(v, cmd); };
+    while (!v->closed()) {
+        sink.drain(draw);
+        v->render();
     }
-    return 0;
+    sink.close();
+    planner.join();
+    if (sink.dropped() > 0) {
+        std::cerr << sink.dropped() << " draw commands dropped, try --decimate\n";
+    }
+    return found ? 0 : 1;
 }
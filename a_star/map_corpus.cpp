@@ -0,0 +1,232 @@
+#include "map_corpus.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "math_util.hpp"
+
+#define START_CLEARANCE 1.5f    // meter
+#define MAX_POSE_TRIES  10000
+
+#define PARKING_MARGIN  5.0f    // meter
+#define PARKING_AISLE   7.0f    // meter
+#define SLOT_WIDTH      2.6f    // meter
+#define SLOT_LENGTH     5.2f    // meter
+#define CAR_WIDTH       2.0f    // meter
+#define CAR_LENGTH      4.6f    // meter
+#define SLOT_TAKEN_PROB 0.85f
+
+#define MAZE_CELL       8.0f    // meter
+#define WALL_THICKNESS  1.0f    // meter
+
+#define CORRIDOR_WIDTH  3.0f    // meter
+
+const std::string& stringify(MapKind kind)
+{
+    static std::string cluttered{"cluttered"};
+    static std::string parking_lot{"parking_lot"};
+    static std::string maze{"maze"};
+    static std::string narrow_corridor{"narrow_corridor"};
+    static std::string unknown{"unknown"};
+
+    switch (kind) {
+    case MAP_CLUTTERED: return cluttered;
+    case MAP_PARKING_LOT: return parking_lot;
+    case MAP_MAZE: return maze;
+    case MAP_NARROW_CORRIDOR: return narrow_corridor;
+    case NUM_MAP_KINDS: break;
+    }
+    return unknown;
+}
+
+bool parse_map_kind(const std::string& name, MapKind& kind)
+{
+    for (int k = 0; k < NUM_MAP_KINDS; ++k) {
+        if (name == stringify(static_cast<MapKind>(k))) {
+            kind = static_cast<MapKind>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+// obstacle covering [x0, x1] x [y0, y1]
+static void add_box(MapGen& gen, float x0, float y0, float x1, float y1)
+{
+    gen.add_obstacle((x0 + x1) / 2.0f, (y0 + y1) / 2.0f, y1 - y0, x1 - x0);
+}
+
+bool is_free(const DenseMap& map, float x, float y, float clearance)
+{
+    const float x_res{(map.x_range[1] - map.x_range[0]) / map.row};
+    const float y_res{(map.y_range[1] - map.y_range[0]) / map.col};
+    for (float px = x - clearance; px <= x + clearance; px += x_res) {
+        for (float py = y - clearance; py <= y + clearance; py += y_res) {
+            const int idx{grid_index(map, px, py)};
+            if (idx < 0 || map.grid_status[idx] > 0) return false;
+        }
+    }
+    return true;
+}
+
+static bool sample_free(const DenseMap& map, std::mt19937& rng, float x0, float x1, float y0, float y1, float clearance,
+    Pose& pose)
+{
+    std::uniform_real_distribution<float> x{x0, x1};
+    std::uniform_real_distribution<float> y{y0, y1};
+    std::uniform_real_distribution<float> heading{static_cast<float>(-M_PI), static_cast<float>(M_PI)};
+    for (int i = 0; i < MAX_POSE_TRIES; ++i) {
+        const Pose p{.x=x(rng), .y=y(rng), .heading=heading(rng)};
+        if (is_free(map, p.x, p.y, clearance)) {
+            pose = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool random_free_pose(const DenseMap& map, std::mt19937& rng, float clearance, Pose& pose)
+{
+    return sample_free(map, rng, map.x_range[0], map.x_range[1], map.y_range[0], map.y_range[1], clearance, pose);
+}
+
+static bool cluttered(CorpusMap& cm, MapGen& gen, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> pos{0.0f, cm.size};
+    std::uniform_real_distribution<float> extent{1.0f, std::max(1.5f, cm.size * 0.08f)};
+    // 40 boxes per 100 m x 100 m
+    const int n{static_cast<int>(cm.size * cm.size / 250.0f)};
+    for (int i = 0; i < n; ++i) {
+        const float x{pos(rng)};
+        const float y{pos(rng)};
+        gen.add_obstacle(x, y, extent(rng), extent(rng));
+    }
+
+    if (!random_free_pose(gen.map, rng, START_CLEARANCE, cm.start)) return false;
+    for (int i = 0; i < MAX_POSE_TRIES; ++i) {
+        if (!random_free_pose(gen.map, rng, START_CLEARANCE, cm.goal)) return false;
+        if (euclidean_dist(cm.start, cm.goal) >= cm.size / 2.0f) break;
+    }
+    return true;
+}
+
+static bool parking_lot(CorpusMap& cm, MapGen& gen, std::mt19937& rng)
+{
+    // a free cross aisle on the left joins the rows, each row faces the aisle above it
+    const float x_begin{PARKING_MARGIN + PARKING_AISLE};
+    const float x_end{cm.size - PARKING_MARGIN};
+    std::uniform_real_distribution<float> u01{0.0f, 1.0f};
+    std::vector<std::pair<float, float>> empty_slots;
+    for (float y = PARKING_MARGIN; y + SLOT_LENGTH + PARKING_AISLE <= cm.size; y += SLOT_LENGTH + PARKING_AISLE) {
+        for (float x = x_begin; x + SLOT_WIDTH <= x_end; x += SLOT_WIDTH) {
+            const float cx{x + SLOT_WIDTH / 2.0f};
+            const float cy{y + SLOT_LENGTH / 2.0f};
+            if (u01(rng) < SLOT_TAKEN_PROB) {
+                add_box(gen, cx - CAR_WIDTH / 2.0f, cy - CAR_LENGTH / 2.0f, cx + CAR_WIDTH / 2.0f, cy + CAR_LENGTH / 2.0f);
+            } else {
+                empty_slots.push_back({cx, cy});
+            }
+        }
+    }
+
+    cm.start = {.x=PARKING_MARGIN + PARKING_AISLE / 2.0f, .y=PARKING_MARGIN, .heading=static_cast<float>(M_PI_2)};
+    if (empty_slots.empty()) {
+        cm.goal = {.x=x_end, .y=PARKING_MARGIN + SLOT_LENGTH + PARKING_AISLE / 2.0f, .heading=0.0f};
+        return true;
+    }
+    std::uniform_int_distribution<size_t> slot{0, empty_slots.size() - 1};
+    const auto& s{empty_slots[slot(rng)]};
+    cm.goal = {.x=s.first, .y=s.second, .heading=static_cast<float>(-M_PI_2)};
+    return true;
+}
+
+static bool maze(CorpusMap& cm, MapGen& gen, std::mt19937& rng)
+{
+    const int n{std::max(2, static_cast<int>(cm.size / MAZE_CELL))};
+    const float cell{cm.size / n};
+
+    // recursive backtracker, right_open / top_open mark the carved walls
+    std::vector<char> visited(n * n, 0);
+    std::vector<char> right_open(n * n, 0);
+    std::vector<char> top_open(n * n, 0);
+    std::vector<int> stack{0};
+    visited[0] = 1;
+    while (!stack.empty()) {
+        const int c{stack.back()};
+        const int i{c % n};
+        const int j{c / n};
+        int next[4];
+        int num_next{0};
+        if (i > 0 && !visited[c - 1]) next[num_next++] = c - 1;
+        if (i + 1 < n && !visited[c + 1]) next[num_next++] = c + 1;
+        if (j > 0 && !visited[c - n]) next[num_next++] = c - n;
+        if (j + 1 < n && !visited[c + n]) next[num_next++] = c + n;
+        if (num_next == 0) {
+            stack.pop_back();
+            continue;
+        }
+        const int to{next[std::uniform_int_distribution<int>{0, num_next - 1}(rng)]};
+        if (to == c + 1) right_open[c] = 1;
+        if (to == c - 1) right_open[to] = 1;
+        if (to == c + n) top_open[c] = 1;
+        if (to == c - n) top_open[to] = 1;
+        visited[to] = 1;
+        stack.push_back(to);
+    }
+
+    const float half{WALL_THICKNESS / 2.0f};
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i < n; ++i) {
+            const int c{j * n + i};
+            if (i + 1 < n && !right_open[c]) {
+                add_box(gen, (i + 1) * cell - half, j * cell - half, (i + 1) * cell + half, (j + 1) * cell + half);
+            }
+            if (j + 1 < n && !top_open[c]) {
+                add_box(gen, i * cell - half, (j + 1) * cell - half, (i + 1) * cell + half, (j + 1) * cell + half);
+            }
+        }
+    }
+
+    cm.start = {.x=cell / 2.0f, .y=cell / 2.0f, .heading=0.0f};
+    cm.goal = {.x=cm.size - cell / 2.0f, .y=cm.size - cell / 2.0f, .heading=static_cast<float>(M_PI_2)};
+    return true;
+}
+
+static bool narrow_corridor(CorpusMap& cm, MapGen& gen, std::mt19937& rng)
+{
+    const float length{std::min(20.0f, cm.size * 0.3f)};
+    const float x0{(cm.size - length) / 2.0f};
+    const float x1{x0 + length};
+    const float center{std::uniform_real_distribution<float>{cm.size * 0.2f, cm.size * 0.8f}(rng)};
+    add_box(gen, x0, 0.0f, x1, center - CORRIDOR_WIDTH / 2.0f);
+    add_box(gen, x0, center + CORRIDOR_WIDTH / 2.0f, x1, cm.size);
+
+    return sample_free(gen.map, rng, 0.0f, x0 - START_CLEARANCE, 0.0f, cm.size, START_CLEARANCE, cm.start) &&
+        sample_free(gen.map, rng, x1 + START_CLEARANCE, cm.size, 0.0f, cm.size, START_CLEARANCE, cm.goal);
+}
+
+bool make_corpus_map(MapKind kind, float size, float resolution, unsigned int seed, CorpusMap& cm)
+{
+    const int cells{std::max(1, static_cast<int>(size / resolution + 0.5f))};
+    MapGen gen{0.0f, size, 0.0f, size, cells, cells};
+    std::mt19937 rng{seed};
+    cm = {
+        .kind=kind,
+        .size=size,
+        .seed=seed,
+        .map={},
+        .start={},
+        .goal={}
+    };
+
+    bool ok{false};
+    switch (kind) {
+    case MAP_CLUTTERED: ok = cluttered(cm, gen, rng); break;
+    case MAP_PARKING_LOT: ok = parking_lot(cm, gen, rng); break;
+    case MAP_MAZE: ok = maze(cm, gen, rng); break;
+    case MAP_NARROW_CORRIDOR: ok = narrow_corridor(cm, gen, rng); break;
+    case NUM_MAP_KINDS: break;
+    }
+    cm.map = std::move(gen.map);
+    return ok;
+}
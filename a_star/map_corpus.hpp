@@ -0,0 +1,48 @@
+#ifndef A_STAR_MAP_CORPUS_H_
+#define A_STAR_MAP_CORPUS_H_
+
+#include <random>
+#include <string>
+#include "map_gen.hpp"
+
+enum MapKind {
+    MAP_CLUTTERED = 0,      // random boxes
+    MAP_PARKING_LOT,        // rows of parked cars along aisles, a few empty slots
+    MAP_MAZE,               // perfect maze carved on a coarse grid
+    MAP_NARROW_CORRIDOR,    // two rooms joined by one corridor
+    NUM_MAP_KINDS,
+}; // enum MapKind
+
+const std::string& stringify(MapKind kind);
+// false if the name is not a map kind
+bool parse_map_kind(const std::string& name, MapKind& kind);
+
+struct Pose
+{
+    float x;
+    float y;
+    float heading;
+}; // struct Pose
+
+// One benchmark case: a square map over [0, size] x [0, size] and a
+// start / goal pair in free space, fully determined by (kind, size, seed).
+struct CorpusMap
+{
+    MapKind kind;
+    float size;             // meter
+    unsigned int seed;
+    DenseMap map;
+    Pose start;
+    Pose goal;
+}; // struct CorpusMap
+
+// false if no free start or goal was found, the map is too cluttered
+bool make_corpus_map(MapKind kind, float size, float resolution, unsigned int seed, CorpusMap& cm);
+
+// true if every cell within `clearance` of (x, y) is free and on the map
+bool is_free(const DenseMap& map, float x, float y, float clearance);
+// a pose at least `clearance` away from obstacles and the map border, false
+// if none was found
+bool random_free_pose(const DenseMap& map, std::mt19937& rng, float clearance, Pose& pose);
+
+#endif // A_STAR_MAP_CORPUS_H_
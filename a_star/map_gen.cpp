@@ -28,12 +28,12 @@ void MapGen::add_obstacle(float center_x, float center_y, float width, float len
     const auto x_inc{std::min(x_res, half_length)};
     const auto y_inc{std::min(y_res, half_width)};
     for (float x = center_x - half_length; x < center_x + half_length; x += x_inc) {
-        if (x >= map.x_range[1] && x <= map.x_range[0]) {
+        if (x < map.x_range[0] || x >= map.x_range[1]) {
             continue;
         }
         const auto r{map.row - 1 - static_cast<int>((x - map.x_range[0]) / x_res)};
         for (float y = center_y - half_width; y < center_y + half_width; y += y_inc) {
-            if (y >= map.y_range[1] && y <= map.y_range[0]) {
+            if (y < map.y_range[0] || y >= map.y_range[1]) {
                 continue;
             }
             const auto c{map.col - 1 - static_cast<int>((y - map.y_range[0]) / y_res)};
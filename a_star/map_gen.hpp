@@ -1,6 +1,7 @@
 #ifndef A_STAR_MAP_GEN_H_
 #define A_STAR_MAP_GEN_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include "rviz.hpp"
@@ -24,4 +25,17 @@ struct MapGen
 
 void to_rviz_map(const DenseMap& map, rviz::GridMap2d& rviz_map);
 
+// index of the cell covering (x, y) in grid_status, -1 if outside the map
+inline int grid_index(const DenseMap& map, float x, float y)
+{
+    if (x < map.x_range[0] || x >= map.x_range[1] || y < map.y_range[0] || y >= map.y_range[1]) {
+        return -1;
+    }
+    const auto x_res{(map.x_range[1] - map.x_range[0]) / map.row};
+    const auto y_res{(map.y_range[1] - map.y_range[0]) / map.col};
+    const auto r{std::max(0, map.row - 1 - static_cast<int>((x - map.x_range[0]) / x_res))};
+    const auto c{std::max(0, map.col - 1 - static_cast<int>((y - map.y_range[0]) / y_res))};
+    return r * map.col + c;
+}
+
 #endif // A_STAR_MAP_GEN_H_
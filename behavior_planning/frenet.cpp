@@ -0,0 +1,252 @@
+#include "frenet.hpp"
+#include <algorithm>
+#include <cmath>
+
+#define FRENET_CHUNK 64     // candidates sampled together, their scratch stays in L1
+
+FrenetConfig default_frenet_config()
+{
+    return {
+        .horizon=5.0f,
+        .dt=0.1f,
+        .min_t=1.5f,
+        .max_t=5.0f,
+        .num_t=8,
+        .min_spd=0.0f,
+        .max_spd=36.0f,
+        .num_spd=10,
+        .num_offsets=5,
+        .offset_range=0.5f,
+        .max_vel=40.0f,
+        .max_accel=3.0f,
+        .max_decel=-8.0f,
+        .max_lat_accel=4.0f,
+        .veh_length=5.0f,
+        .veh_width=2.0f,
+        .jerk_weight=0.1f,
+        .time_weight=0.5f,
+        .offset_weight=2.0f,
+        .speed_weight=1.0f,
+        .lane_change_cost=10.0f,
+        .lat_weight=1.0f,
+        .lon_weight=1.0f,
+    };
+}
+
+static inline float lerp_n(float lo, float hi, int i, int n)
+{
+    return n > 1 ? lo + (hi - lo) * i / (n - 1) : hi;
+}
+
+FrenetState FrenetPath::at(float t) const
+{
+    const float tc{std::min(t, t_end)};
+    const float in{t <= t_end ? 1.0f : 0.0f};
+    return {
+        .s=lon[0] + tc * (lon[1] + tc * (lon[2] + tc * (lon[3] + tc * lon[4]))) + target_spd * (t - tc),
+        .s_d=lon[1] + tc * (2.0f * lon[2] + tc * (3.0f * lon[3] + tc * 4.0f * lon[4])),
+        .s_dd=in * (2.0f * lon[2] + tc * (6.0f * lon[3] + tc * 12.0f * lon[4])),
+        .d=lat[0] + tc * (lat[1] + tc * (lat[2] + tc * (lat[3] + tc * (lat[4] + tc * lat[5])))),
+        .d_d=in * (lat[1] + tc * (2.0f * lat[2] + tc * (3.0f * lat[3] + tc * (4.0f * lat[4] + tc * 5.0f * lat[5])))),
+        .d_dd=in * (2.0f * lat[2] + tc * (6.0f * lat[3] + tc * (12.0f * lat[4] + tc * 20.0f * lat[5]))),
+    };
+}
+
+FrenetPlanner::FrenetPlanner(const FrenetConfig& cfg, tp::ThreadPool* pool)
+    : cfg_(cfg)
+    , pool_(pool)
+    , start_lane_(0)
+    , feasible_(0)
+{
+    const size_t n{static_cast<size_t>(NUM_LANES) * std::max(1, cfg_.num_offsets) *
+        std::max(1, cfg_.num_t) * std::max(1, cfg_.num_spd)};
+    lane_id_.reserve(n);
+    t_end_.reserve(n);
+    target_d_.reserve(n);
+    target_spd_.reserve(n);
+    for (auto& c : lat_) c.reserve(n);
+    for (auto& c : lon_) c.reserve(n);
+    cost_.reserve(n);
+}
+
+bool FrenetPlanner::plan(const FrenetState& start, const Scene& scene, FrenetPath& best)
+{
+    generate(start);
+    predict(start, scene);
+
+    const int n{static_cast<int>(t_end_.size())};
+    cost_.resize(n);
+    if (pool_ != nullptr && pool_->size() > 1) {
+        // whole chunks per task, so no two workers write the same cache line
+        const int per_worker{(n + pool_->size() - 1) / pool_->size()};
+        const int grain{(per_worker + FRENET_CHUNK - 1) / FRENET_CHUNK * FRENET_CHUNK};
+        pool_->parallel_for(n, grain, [this](int begin, int end, int) { evaluate(begin, end); });
+    } else {
+        evaluate(0, n);
+    }
+
+    feasible_ = std::count_if(cost_.begin(), cost_.end(), [](float c) { return std::isfinite(c); });
+    const auto i{std::min_element(cost_.begin(), cost_.end()) - cost_.begin()};
+    if (feasible_ == 0) return false;
+
+    best.lane_id = lane_id_[i];
+    best.t_end = t_end_[i];
+    best.target_d = target_d_[i];
+    best.target_spd = target_spd_[i];
+    best.cost = cost_[i];
+    for (int k = 0; k < 6; ++k) best.lat[k] = lat_[k][i];
+    for (int k = 0; k < 5; ++k) best.lon[k] = lon_[k][i];
+    return true;
+}
+
+void FrenetPlanner::generate(const FrenetState& start)
+{
+    start_lane_ = std::clamp(static_cast<int>(std::lround(start.d / LANE_WIDTH)), 0, NUM_LANES - 1);
+
+    lane_id_.clear();
+    t_end_.clear();
+    target_d_.clear();
+    target_spd_.clear();
+    for (auto& c : lat_) c.clear();
+    for (auto& c : lon_) c.clear();
+
+    for (int lane_id = 0; lane_id < NUM_LANES; ++lane_id) {
+        for (int o = 0; o < std::max(1, cfg_.num_offsets); ++o) {
+            const float d1{lane_id * LANE_WIDTH +
+                lerp_n(-cfg_.offset_range, cfg_.offset_range, o, cfg_.num_offsets)};
+            for (int k = 0; k < std::max(1, cfg_.num_t); ++k) {
+                const float t{lerp_n(cfg_.min_t, cfg_.max_t, k, cfg_.num_t)};
+                const float t2{t * t};
+                const float t3{t2 * t};
+
+                // quintic from the start state to (d1, 0, 0) at t
+                const float a2{0.5f * start.d_dd};
+                const float h{d1 - (start.d + start.d_d * t + a2 * t2)};
+                const float hv{-(start.d_d + 2.0f * a2 * t)};
+                const float ha{-start.d_dd};
+                const float a3{(10.0f * h - 4.0f * hv * t + 0.5f * ha * t2) / t3};
+                const float a4{(-15.0f * h + 7.0f * hv * t - ha * t2) / (t3 * t)};
+                const float a5{(6.0f * h - 3.0f * hv * t + 0.5f * ha * t2) / (t3 * t2)};
+
+                for (int v = 0; v < std::max(1, cfg_.num_spd); ++v) {
+                    const float spd{lerp_n(cfg_.min_spd, cfg_.max_spd, v, cfg_.num_spd)};
+
+                    // quartic from the start state to (spd, 0) at t
+                    const float b2{0.5f * start.s_dd};
+                    const float gv{spd - (start.s_d + start.s_dd * t)};
+                    const float ga{-start.s_dd};
+                    const float b3{(3.0f * gv - ga * t) / (3.0f * t2)};
+                    const float b4{(ga * t - 2.0f * gv) / (4.0f * t3)};
+
+                    lane_id_.push_back(lane_id);
+                    t_end_.push_back(t);
+                    target_d_.push_back(d1);
+                    target_spd_.push_back(spd);
+                    lat_[0].push_back(start.d);
+                    lat_[1].push_back(start.d_d);
+                    lat_[2].push_back(a2);
+                    lat_[3].push_back(a3);
+                    lat_[4].push_back(a4);
+                    lat_[5].push_back(a5);
+                    lon_[0].push_back(start.s);
+                    lon_[1].push_back(start.s_d);
+                    lon_[2].push_back(b2);
+                    lon_[3].push_back(b3);
+                    lon_[4].push_back(b4);
+                }
+            }
+        }
+    }
+}
+
+void FrenetPlanner::predict(const FrenetState& start, const Scene& scene)
+{
+    obs_s_.clear();
+    obs_vel_.clear();
+    obs_d_.clear();
+
+    // nobody farther than that can be reached within the horizon
+    const float range{2.0f * cfg_.max_vel * cfg_.horizon + cfg_.veh_length};
+    for (int lane_id = 0; lane_id < NUM_LANES; ++lane_id) {
+        const auto& lane{scene.lane(lane_id)};
+        int i{scene.lead(lane_id, start.s - range)};
+        if (i < 0) continue;
+        for (; i < static_cast<int>(lane.size()) && lane.x[i] < start.s + range; ++i) {
+            obs_s_.push_back(lane.x[i]);
+            obs_vel_.push_back(lane.vel[i]);
+            obs_d_.push_back(lane_id * LANE_WIDTH);
+        }
+    }
+}
+
+void FrenetPlanner::evaluate(int begin, int end)
+{
+    const int steps{static_cast<int>(cfg_.horizon / cfg_.dt + 0.5f)};
+    const size_t num_obs{obs_s_.size()};
+    const float min_ds{cfg_.veh_length};
+    const float min_dd{cfg_.veh_width};
+
+    for (int c0 = begin; c0 < end; c0 += FRENET_CHUNK) {
+        const int n{std::min(FRENET_CHUNK, end - c0)};
+        const float* __restrict t_end{t_end_.data() + c0};
+        const float* __restrict spd{target_spd_.data() + c0};
+        const float* __restrict a0{lat_[0].data() + c0};
+        const float* __restrict a1{lat_[1].data() + c0};
+        const float* __restrict a2{lat_[2].data() + c0};
+        const float* __restrict a3{lat_[3].data() + c0};
+        const float* __restrict a4{lat_[4].data() + c0};
+        const float* __restrict a5{lat_[5].data() + c0};
+        const float* __restrict b0{lon_[0].data() + c0};
+        const float* __restrict b1{lon_[1].data() + c0};
+        const float* __restrict b2{lon_[2].data() + c0};
+        const float* __restrict b3{lon_[3].data() + c0};
+        const float* __restrict b4{lon_[4].data() + c0};
+
+        alignas(64) float s[FRENET_CHUNK];
+        alignas(64) float d[FRENET_CHUNK];
+        alignas(64) float jerk_lat[FRENET_CHUNK]{};
+        alignas(64) float jerk_lon[FRENET_CHUNK]{};
+        alignas(64) int bad[FRENET_CHUNK]{};
+
+        for (int k = 1; k <= steps; ++k) {
+            const float t{k * cfg_.dt};
+            for (int i = 0; i < n; ++i) {
+                const float tc{std::min(t, t_end[i])};
+                const float in{t <= t_end[i] ? 1.0f : 0.0f};
+
+                s[i] = b0[i] + tc * (b1[i] + tc * (b2[i] + tc * (b3[i] + tc * b4[i]))) + spd[i] * (t - tc);
+                const float vel{b1[i] + tc * (2.0f * b2[i] + tc * (3.0f * b3[i] + tc * 4.0f * b4[i]))};
+                const float acc{in * (2.0f * b2[i] + tc * (6.0f * b3[i] + tc * 12.0f * b4[i]))};
+                const float jerk_s{in * (6.0f * b3[i] + tc * 24.0f * b4[i])};
+
+                d[i] = a0[i] + tc * (a1[i] + tc * (a2[i] + tc * (a3[i] + tc * (a4[i] + tc * a5[i]))));
+                const float lat_acc{in * (2.0f * a2[i] + tc * (6.0f * a3[i] + tc * (12.0f * a4[i] + tc * 20.0f * a5[i])))};
+                const float jerk_d{in * (6.0f * a3[i] + tc * (24.0f * a4[i] + tc * 60.0f * a5[i]))};
+
+                jerk_lon[i] += jerk_s * jerk_s;
+                jerk_lat[i] += jerk_d * jerk_d;
+                bad[i] |= (vel < -0.1f) | (vel > cfg_.max_vel) | (acc > cfg_.max_accel) |
+                    (acc < cfg_.max_decel) | (std::fabs(lat_acc) > cfg_.max_lat_accel);
+            }
+
+            for (size_t j = 0; j < num_obs; ++j) {
+                const float os{obs_s_[j] + obs_vel_[j] * t};
+                const float od{obs_d_[j]};
+                for (int i = 0; i < n; ++i) {
+                    bad[i] |= (std::fabs(s[i] - os) < min_ds) & (std::fabs(d[i] - od) < min_dd);
+                }
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            const int lane_id{lane_id_[c0 + i]};
+            const float offset{target_d_[c0 + i] - lane_id * LANE_WIDTH};
+            const float dv{TARGET_SPD - spd[i]};
+            const float lat{cfg_.jerk_weight * jerk_lat[i] * cfg_.dt + cfg_.time_weight * t_end[i] +
+                cfg_.offset_weight * offset * offset + (lane_id != start_lane_ ? cfg_.lane_change_cost : 0.0f)};
+            const float lon{cfg_.jerk_weight * jerk_lon[i] * cfg_.dt + cfg_.time_weight * t_end[i] +
+                cfg_.speed_weight * dv * dv};
+            cost_[c0 + i] = bad[i] ? INFINITY : cfg_.lat_weight * lat + cfg_.lon_weight * lon;
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef BEHAVIOR_PLANNING_FRENET_H_
+#define BEHAVIOR_PLANNING_FRENET_H_
+
+#include <cstddef>
+#include <vector>
+#include "scene.hpp"
+#include "thread_pool.hpp"
+#include "vehicle.hpp"
+
+#define LANE_WIDTH 3.5f     // meter, lane l is centered at d = l * LANE_WIDTH
+
+// The reference line is the center of lane 0, so s is the scene x and
+// d grows to the left like the lane ids.
+struct FrenetState
+{
+    float s;
+    float s_d;
+    float s_dd;
+    float d;
+    float d_d;
+    float d_dd;
+}; // struct FrenetState
+
+struct FrenetConfig
+{
+    float horizon;          // second, every candidate is checked until then
+    float dt;               // second
+    float min_t;            // second, shortest lateral and longitudinal maneuver
+    float max_t;            // second
+    int num_t;
+    float min_spd;          // m/s, lowest target speed of the longitudinal quartic
+    float max_spd;          // m/s
+    int num_spd;
+    int num_offsets;        // lateral end points per lane, spread over +-offset_range
+    float offset_range;     // meter
+    float max_vel;          // m/s
+    float max_accel;        // m/s^2
+    float max_decel;        // m/s^2, negative
+    float max_lat_accel;    // m/s^2
+    float veh_length;       // meter, two centers closer than that along s and
+    float veh_width;        // meter, that along d collide
+    float jerk_weight;
+    float time_weight;
+    float offset_weight;
+    float speed_weight;
+    float lane_change_cost;
+    float lat_weight;
+    float lon_weight;
+}; // struct FrenetConfig
+
+// Quintic d(t) and quartic s(t), both frozen at t_end: d stays at its
+// end point and s keeps the target speed.
+struct FrenetPath
+{
+    int lane_id;
+    float t_end;            // second
+    float target_d;         // meter
+    float target_spd;       // m/s
+    float cost;
+    float lat[6];           // d(t) = sum lat[i] * t^i
+    float lon[5];           // s(t) = sum lon[i] * t^i
+
+    FrenetState at(float t) const;
+}; // struct FrenetPath
+
+// Lattice of (end offset, end time, target speed) candidates around the
+// start state. Candidates are kept as SoA polynomial coefficients, sampled
+// chunk by chunk with loops over the candidates so the compiler vectorizes
+// the feasibility and collision checks, and the chunks are spread over
+// the pool. Participants are predicted at constant velocity.
+class FrenetPlanner
+{
+public:
+    // chunks are evaluated on the pool when one is given
+    FrenetPlanner(const FrenetConfig& cfg, tp::ThreadPool* pool);
+    ~FrenetPlanner() = default;
+
+    // false if every candidate is infeasible or collides
+    bool plan(const FrenetState& start, const Scene& scene, FrenetPath& best);
+
+    inline size_t num_candidates() const { return t_end_.size(); }
+    inline size_t num_feasible() const { return feasible_; }
+private:
+    void generate(const FrenetState& start);
+    void predict(const FrenetState& start, const Scene& scene);
+    void evaluate(int begin, int end);
+
+    FrenetConfig cfg_;
+    tp::ThreadPool* pool_;
+    int start_lane_;
+
+    // candidates
+    std::vector<int> lane_id_;
+    std::vector<float> t_end_;
+    std::vector<float> target_d_;
+    std::vector<float> target_spd_;
+    std::vector<float> lat_[6];
+    std::vector<float> lon_[5];
+    std::vector<float> cost_;
+    size_t feasible_;
+
+    // participants near the start
+    std::vector<float> obs_s_;
+    std::vector<float> obs_vel_;
+    std::vector<float> obs_d_;
+}; // class FrenetPlanner
+
+FrenetConfig default_frenet_config();
+
+inline FrenetState frenet_state(const VehModel& veh)
+{
+    return {
+        .s=veh.position.x,
+        .s_d=veh.vel,
+        .s_dd=veh.accel,
+        .d=veh.lane_id * LANE_WIDTH,
+        .d_d=0.0f,
+        .d_dd=0.0f
+    };
+}
+
+#endif // BEHAVIOR_PLANNING_FRENET_H_
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "frenet.hpp"
+#include "simulation.hpp"
+#include "thread_pool.hpp"
+
+#define CYCLE_MS 20.0   // millisecond, planning budget
+
+struct Options
+{
+    long ticks;
+    int participants;
+    int threads;            // 0 uses every core
+    unsigned int seed;
+}; // struct Options
+
+void usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [--ticks N] [--participants N] [--threads N] [--seed N]\n";
+}
+
+bool parse_options(int argc, char** argv, Options& opts)
+{
+    opts = {.ticks=3000, .participants=10, .threads=0, .seed=0};
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--ticks") == 0) {
+            opts.ticks = std::atol(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--participants") == 0) {
+            opts.participants = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            opts.threads = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            opts.seed = std::strtoul(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && opts.ticks > 0;
+}
+
+// Drive the scenario with the maneuver planner and run the Frenet planner
+// in its shadow every tick, reporting how fast the lattice is evaluated.
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    tp::ThreadPool pool{opts.threads};
+    FrenetPlanner planner{default_frenet_config(), &pool};
+    Simulation sim;
+    const float spawn_range{std::max(100.0f, opts.participants * 11.0f)};
+    sim.reset(opts.seed, {.num_participants=opts.participants, .dt=STEP_SIZE, .spawn_range=spawn_range});
+
+    BehaviorInfo bi;
+    FrenetPath path;
+    long plans{0};
+    long found{0};
+    long same_lane{0};
+    long candidates{0};
+    long feasible{0};
+    double total_ms{0.0};
+    double max_ms{0.0};
+    int hit{-1};
+    while (sim.ticks() < opts.ticks && hit < 0) {
+        hit = sim.tick(bi);
+
+        const auto start{std::chrono::steady_clock::now()};
+        const bool ok{planner.plan(frenet_state(sim.ego()), sim.scene(), path)};
+        const std::chrono::duration<double, std::milli> plan_time{std::chrono::steady_clock::now() - start};
+
+        ++plans;
+        total_ms += plan_time.count();
+        max_ms = std::max(max_ms, plan_time.count());
+        candidates += planner.num_candidates();
+        feasible += planner.num_feasible();
+        if (ok) {
+            ++found;
+            same_lane += path.lane_id == bi.lane_id;
+        }
+    }
+
+    const double avg_ms{total_ms / std::max(1L, plans)};
+    const double avg_candidates{static_cast<double>(candidates) / std::max(1L, plans)};
+    std::cout << "== FRENET ==\n"
+              << " seed: " << opts.seed << "\n"
+              << " workers: " << pool.size() << "\n"
+              << " plans: " << plans << (hit >= 0 ? " (ended by a collision)" : "") << "\n"
+              << " candidates: " << avg_candidates << " per plan, "
+              << static_cast<double>(feasible) / std::max(1L, candidates) << " feasible\n"
+              << " plan: " << avg_ms << " ms avg, " << max_ms << " ms max\n"
+              << " throughput: " << avg_candidates * CYCLE_MS / std::max(avg_ms, 1.0e-9)
+              << " candidates per " << CYCLE_MS << " ms\n"
+              << " found: " << found << ", same lane as the maneuver planner: "
+              << static_cast<double>(same_lane) / std::max(1L, found) << "\n";
+    return 0;
+}
@@ -1,299 +1,282 @@
-#include <cassert>
-#include <cmath>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
-#include <ostream>
 #include <thread>
-#include <vector>
+#include "report.hpp"
+#include "ring_buffer.hpp"
+#include "scene_log.hpp"
+#include "simulation.hpp"
+#include "thread_pool.hpp"
 
-using namespace std::chrono_literals;
-
-#define NUM_LANES 3
-#define TARGET_SPD 30.0f // mps
-#define STEP_SIZE 0.02f
-
-enum Behavior {
-    BH_UNKNOWN = 0,
-    BH_CRUISE,
-    BH_FOLLOW,
-    BH_AEB,
-    BH_COMFORT_STOP,
-    BH_CHANGE_LEFT,
-    BH_CHANGE_RIGHT,
-}; // enum Behavior
-
-inline const std::string& stringify(Behavior b)
+struct Options
 {
-    static std::string bh_unknown{"UNKNOWN"};
-    static std::string bh_cruise{"CRUISE"};
-    static std::string bh_follow{"FOLLOW"};
-    static std::string bh_aeb{"AEB"};
-    static std::string bh_comfort_stop{"COMFORT_STOP"};
-    static std::string bh_change_left{"CHANGE_LEFT"};
-    static std::string bh_change_right{"CHANGE_RIGHT"};
-
-    switch (b) {
-    case BH_UNKNOWN: return bh_unknown;
-    case BH_CRUISE: return bh_cruise;
-    case BH_FOLLOW: return bh_follow;
-    case BH_AEB: return bh_aeb;
-    case BH_COMFORT_STOP: return bh_comfort_stop;
-    case BH_CHANGE_LEFT: return bh_change_left;
-    case BH_CHANGE_RIGHT: return bh_change_right;
-    }
-    return bh_unknown;
-}
-
-template<typename T>
-inline T rand_ab(T a, T b)
+    bool headless;
+    long ticks;             // < 0 runs until a collision
+    float dt;               // second
+    size_t report_size;     // ticks kept for the headless report, 0 prints the summary only
+    unsigned int seed;
+    int participants;
+    int threads;            // scoring the ego candidates, 0 uses every core
+    const char* record;     // scene log written while running
+    const char* replay;     // scene log to re-plan instead of simulating
+    long from;              // first tick replayed
+}; // struct Options
+
+void report_collision(const Simulation& sim, int hit)
 {
-    assert(b > a);
-    float rv{static_cast<float>(rand()) / static_cast<float>(RAND_MAX)};
-    return rv * (b - a) + a;
+    const auto& ego{sim.ego()};
+    const auto& lane{sim.scene().lane(ego.lane_id)};
+    std::cout << "== EGO ==\n"
+              << "  position: " << ego.position << "\n"
+              << "  lane id: " << ego.lane_id << "\n"
+              << "  vel: " << ego.vel << "\n"
+              << "== TARGET ==\n"
+              << "  position: " << Vec2{.x=lane.x[hit], .y=0.0f} << "\n"
+              << "  lane id: " << ego.lane_id << "\n"
+              << "  id: " << lane.id[hit] << "\n"
+              << "  vel: " << lane.vel[hit] << "\n";
 }
 
-inline bool prob(float p)
+void report_behavior(const Simulation& sim, const BehaviorInfo& bi)
 {
-    return rand_ab(0.0f, 1.0f) < p;
+    const auto& ego{sim.ego()};
+    std::cout << "The plan behavior: " << stringify(bi.behavior);
+    if (bi.lead_id >= 0) {
+        std::cout
+            << ", lead: " << bi.lead_position
+            << ", ego: " << ego.position
+            << ", lead id: " << bi.lead_id
+            << ", vel: " << ego.vel
+            << ", lead vel: " << bi.lead_vel
+            << ", lead lane id: " << bi.lead_lane_id;
+    }
+    std::cout << "\n";
 }
 
-template<typename T>
-inline T abs(T v) { return v > 0 ? v : -v; }
-
-inline int gen_id()
+void report_scene(const Simulation& sim)
 {
-    static int cnt{0};
-    return (cnt++ % 100000);
+    const auto& ego{sim.ego()};
+    std::cout << "== EGO ==\n"
+        << " position: " << ego.position << "\n"
+        << " vel: " << ego.vel << "\n"
+        << " accel: " << ego.accel << "\n";
+    std::cout << "== PARTICIPANTS ==\n";
+    for (int l = 0; l < NUM_LANES; ++l) {
+        const auto& lane{sim.scene().lane(l)};
+        for (size_t i = 0; i < lane.size(); ++i) {
+            std::cout
+                << " position: " << Vec2{.x=lane.x[i], .y=0.0f} << "\n"
+                << " vel: " << lane.vel[i] << "\n"
+                << " accel: " << lane.accel[i] << "\n"
+                << "---\n";
+        }
+    }
 }
 
-struct Vec2
+void usage(const char* prog)
 {
-    float x;
-    float y;
-}; // struct Vec2
-
-struct Control
-{
-    float accel;
-}; // struct Control
-
-std::ostream& operator<<(std::ostream& os, const Vec2& v)
-{
-    os << "(" << v.x << ", " << v.y << ")";
-    return os;
+    std::cerr << "usage: " << prog << " [--headless] [--ticks N] [--dt SECONDS] [--report N] [--seed N]"
+              << " [--participants N] [--threads N] [--record FILE]\n"
+              << "       " << prog << " --replay FILE [--from TICK] [--ticks N] [--report N]\n";
 }
 
-struct BehaviorInfo
-{
-    int lane_id;
-    int lead_id;
-    int lead_lane_id;
-    float lead_vel;
-    float lead_accel;
-    Vec2 lead_position;
-    Behavior behavior;
-}; // struct BehaviorInfo
-
-struct VehModel
-{
-    int id;
-    int lane_id;
-    float heading;
-    float accel;
-    float vel;
-    bool controled;
-    Vec2 position;
-
-    void step(float dt);
-    void act(const Control& control);
-    void behavior_plan(BehaviorInfo& bi);
-    void vel_plan(const BehaviorInfo& bi, Control& control);
-}; // struct VehModel
-
-std::vector<VehModel> participants;
-VehModel ego;
-
-void VehModel::step(float dt)
+bool parse_options(int argc, char** argv, Options& opts)
 {
-    vel += accel * dt;
-    position.x += vel * dt;
-    if (!controled) {
-        if (vel > 10.0f) {
-            accel += rand_ab(-0.1f, 0.1f);
+    opts = {
+        .headless=false,
+        .ticks=-1,
+        .dt=STEP_SIZE,
+        .report_size=1024,
+        .seed=static_cast<unsigned int>(time(NULL)),
+        .participants=10,
+        .threads=0,
+        .record=nullptr,
+        .replay=nullptr,
+        .from=0
+    };
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            opts.headless = true;
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && has_value) {
+            opts.ticks = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "--dt") == 0 && has_value) {
+            opts.dt = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--report") == 0 && has_value) {
+            const long n{std::atol(argv[++i])};
+            if (n < 0) return false;
+            opts.report_size = n;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            opts.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--participants") == 0 && has_value) {
+            opts.participants = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            opts.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--record") == 0 && has_value) {
+            opts.record = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && has_value) {
+            opts.replay = argv[++i];
+        } else if (std::strcmp(argv[i], "--from") == 0 && has_value) {
+            opts.from = std::atol(argv[++i]);
         } else {
-            accel += 0.1f;
-        }
-
-        bool ch_lane{prob(0.02f) && abs(position.x - ego.position.x) > 5.0f};
-        if (ch_lane) {
-            lane_id = (lane_id + 1) % NUM_LANES;
-            std::cout << "Change lane, ego: " << ego.position << ", par: " << position << ", "
-                      << "lead vel: " << vel << "\n";
+            return false;
         }
     }
+    return opts.dt > 0.0f;
 }
 
-bool check_collision()
+// Run with a virtual clock and no iostream on the tick path, the latest
+// ticks are kept in a ring buffer and printed when the run ends.
+int run_headless(Simulation& sim, const Options& opts)
 {
-    for (const auto& p : participants) {
-        if (p.lane_id == ego.lane_id &&
-            abs(p.position.x - ego.position.x) < 5.0f &&
-            p.position.x > ego.position.x &&
-            p.vel > ego.vel) {
-            std::cout << "== EGO ==\n"
-                      << "  position: " << ego.position << "\n"
-                      << "  lane id: " << ego.lane_id << "\n"
-                      << "  vel: " << ego.vel << "\n"
-                      << "== TARGET ==\n"
-                      << "  position: " << p.position << "\n"
-                      << "  lane id: " << p.lane_id << "\n"
-                      << "  id: " << p.id << "\n"
-                      << "  vel: " << p.vel << "\n";
-            return true;
-        }
+    RingBuffer<TickReport> reports{opts.report_size};
+    long behavior_count[BH_CHANGE_RIGHT + 1]{};
+    BehaviorInfo bi;
+    int hit{-1};
+    double max_tick_ms{0.0};
+
+    const auto start{std::chrono::steady_clock::now()};
+    while (opts.ticks < 0 || sim.ticks() < opts.ticks) {
+        const auto tick_start{std::chrono::steady_clock::now()};
+        hit = sim.tick(bi);
+        const std::chrono::duration<double, std::milli> tick_time{std::chrono::steady_clock::now() - tick_start};
+        max_tick_ms = std::max(max_tick_ms, tick_time.count());
+        reports.push(make_report(sim.ticks() - 1, sim.ego(), bi));
+        ++behavior_count[bi.behavior];
+        if (hit >= 0) break;
     }
-    return false;
-}
+    const std::chrono::duration<double> wall{std::chrono::steady_clock::now() - start};
 
-void VehModel::act(const Control& control)
-{
-    accel = control.accel;
-}
-
-void VehModel::behavior_plan(BehaviorInfo& bi)
-{
-    bi.behavior = BH_CRUISE;
-    bi.lead_id = -1;
+    for (size_t i = 0; i < reports.size(); ++i) {
+        std::cout << reports.at(i) << "\n";
+    }
+    if (hit >= 0) {
+        report_collision(sim, hit);
+    }
 
-    if (!participants.empty()) {
-        float nearest_follow{INFINITY};
-        for (const auto& p : participants) {
-            if (p.lane_id == ego.lane_id) {
-                if (p.position.x >= ego.position.x && p.position.x < nearest_follow &&
-                    abs(p.position.x - ego.position.x) < 80.0f) {
-                    nearest_follow = p.position.x;
-                    bi.behavior = BH_FOLLOW;
-                    bi.lead_accel = p.accel;
-                    bi.lead_id = p.id;
-                    bi.lead_lane_id = p.lane_id;
-                    bi.lead_position = p.position;
-                    bi.lead_vel = p.vel;
-                }
-            }
+    const double sim_time{sim.ticks() * static_cast<double>(opts.dt)};
+    std::cout << "== SUMMARY ==\n"
+              << " seed: " << opts.seed << "\n"
+              << " ticks: " << sim.ticks() << "\n"
+              << " simulated: " << sim_time << " s\n"
+              << " wall: " << wall.count() << " s\n"
+              << " speedup: " << sim_time / std::max(wall.count(), 1.0e-9) << "x\n"
+              << " tick: " << wall.count() * 1000.0 / std::max(1L, sim.ticks()) << " ms avg, "
+              << max_tick_ms << " ms max (budget " << opts.dt * 1000.0f << " ms)\n";
+    for (int b = 0; b <= BH_CHANGE_RIGHT; ++b) {
+        if (behavior_count[b] > 0) {
+            std::cout << " " << stringify(static_cast<Behavior>(b)) << ": " << behavior_count[b] << "\n";
         }
     }
+
+    if (hit >= 0) {
+        std::cerr << "Collision!!\n";
+        return 1;
+    }
+    return 0;
 }
 
-void VehModel::vel_plan(const BehaviorInfo& bi, Control& control)
+// Re-plan every logged tick from its snapshot and compare with the logged
+// decision, the planner is deterministic so any difference is a regression.
+int run_replay(const Options& opts)
 {
-    if (vel < 0.001) {
-        accel = 0.0f;
+    SceneLogReader reader;
+    if (!reader.open(opts.replay)) {
+        std::cerr << "Open scene log " << opts.replay << " failed\n";
+        return 1;
     }
-    switch (bi.behavior) {
-    case BH_FOLLOW:
-        if (vel > bi.lead_vel) {
-            accel = -5.0f;
-        } else {
-            accel = 0.0f;
-        }
-        break;
-    case BH_AEB:
-        break;
-    case BH_COMFORT_STOP:
-        break;
-    case BH_CHANGE_LEFT:
-        break;
-    case BH_CHANGE_RIGHT:
-        break;
-    case BH_CRUISE:
-    case BH_UNKNOWN:
-    default:
-        break;
+    const long first{reader.find(opts.from)};
+    if (first < 0) {
+        std::cerr << "Tick " << opts.from << " is not in " << opts.replay << "\n";
+        return 1;
     }
-}
 
-void report_behavior(const BehaviorInfo& bi)
-{
-    std::cout << "The plan behavior: " << stringify(bi.behavior);
-    if (bi.behavior == BH_FOLLOW) {
-        std::cout
-            << ", lead: " << bi.lead_position
-            << ", ego: " << ego.position
-            << ", lead id: " << bi.lead_id
-            << ", vel: " << ego.vel
-            << ", lead vel: " << bi.lead_vel
-            << ", lead lane id: " << bi.lead_lane_id;
+    tp::ThreadPool pool{opts.threads};
+    ManeuverPlanner planner{default_maneuver_config(), &pool};
+    RingBuffer<TickReport> reports{opts.report_size};
+    Scene scene;
+    VehModel ego;
+    BehaviorInfo logged;
+    BehaviorInfo bi;
+    long tick;
+    long mismatches{0};
+
+    const long total{static_cast<long>(reader.size())};
+    const long last{opts.ticks < 0 ? total : std::min(total, first + opts.ticks)};
+    for (long i = first; i < last; ++i) {
+        reader.load(i, tick, ego, scene, logged);
+        planner.plan(ego, scene, bi);
+        reports.push(make_report(tick, ego, bi));
+        if (bi.behavior != logged.behavior || bi.lane_id != logged.lane_id || bi.accel != logged.accel) {
+            ++mismatches;
+            std::cout << "mismatch at tick " << tick << "\n"
+                      << "  logged: " << make_report(tick, ego, logged) << "\n"
+                      << "  replay: " << make_report(tick, ego, bi) << "\n";
+        }
     }
-    std::cout << "\n";
-}
 
-void report_scene()
-{
-    std::cout << "== EGO ==\n"
-        << " position: " << ego.position << "\n"
-        << " vel: " << ego.vel << "\n"
-        << " accel: " << ego.accel << "\n";
-    std::cout << "== PARTICIPANTS ==\n";
-    for (const auto& p: participants) {
-        std::cout
-            << " position: " << p.position << "\n"
-            << " vel: " << p.vel << "\n"
-            << " accel: " << p.accel << "\n"
-            << "---\n";
+    for (size_t i = 0; i < reports.size(); ++i) {
+        std::cout << reports.at(i) << "\n";
     }
+    std::cout << "== REPLAY ==\n"
+              << " seed: " << reader.header().seed << "\n"
+              << " ticks: " << last - first << "\n"
+              << " mismatches: " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
 }
 
-void step(float dt)
+int run_realtime(Simulation& sim, const Options& opts)
 {
-    ego.step(STEP_SIZE);
-    for (auto& p: participants) {
-        p.step(STEP_SIZE);
+    BehaviorInfo bi;
+    while (opts.ticks < 0 || sim.ticks() < opts.ticks) {
+        std::this_thread::sleep_for(std::chrono::duration<float>(opts.dt));
+        const int hit{sim.tick(bi)};
+
+        report_behavior(sim, bi);
+        if (hit >= 0) {
+            report_collision(sim, hit);
+            std::cerr << "Collision!!\n";
+            return 1;
+        }
+
+        if ((sim.ticks() - 1) % 100 == 0)
+            report_scene(sim);
     }
+    return 0;
 }
 
-int main()
+int main(int argc, char** argv)
 {
-    srand(time(NULL));
-
-    ego.lane_id = 1;
-    ego.id = gen_id();
-    ego.controled = true;
-    ego.vel = 20.0f;
-
-    VehModel p{};
-    for (int i = 0; i < 10; ++i) {
-        p.id = gen_id();
-        p.lane_id = rand_ab(0, NUM_LANES - 1);
-        p.position.x = rand_ab(-10.0f, 100.0f);
-        p.accel = 0.0f;
-        p.vel = rand_ab(10.0f, 40.0f);
-        if (p.lane_id == ego.lane_id &&
-            abs(p.position.x - ego.position.x) < 5.0f) {
-            continue;
-            --i;
-        }
-        participants.push_back(p);
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        usage(argv[0]);
+        return 1;
     }
 
-    BehaviorInfo bi;
-    Control control;
-    while (true) {
-        std::this_thread::sleep_for(20ms);
-        step(0.02f);
-        ego.behavior_plan(bi);
-        ego.vel_plan(bi, control);
-        ego.act(control);
+    if (opts.replay != nullptr) {
+        return run_replay(opts);
+    }
 
-        report_behavior(bi);
-        if (check_collision()) {
-            std::cerr << "Collision!!\n";
+    tp::ThreadPool pool{opts.threads};
+    Simulation sim{&pool};
+    SceneLogWriter log;
+    if (opts.record != nullptr) {
+        if (!log.open(opts.record, opts.seed, opts.dt)) {
+            std::cerr << "Open scene log " << opts.record << " failed\n";
             return 1;
         }
-
-        static int cnt{0};
-        if (cnt++ % 100 == 0)
-            report_scene();
+        sim.set_log(&log);
     }
-    return 0;
+    // keep the density of the default 10 participants over 110 m
+    const float spawn_range{std::max(100.0f, opts.participants * 11.0f)};
+    sim.reset(opts.seed, {.num_participants=opts.participants, .dt=opts.dt, .spawn_range=spawn_range});
+    const int ret{opts.headless ? run_headless(sim, opts) : run_realtime(sim, opts)};
+    if (!log.close()) {
+        std::cerr << "Write scene log " << opts.record << " failed\n";
+        return 1;
+    }
+    return ret;
 }
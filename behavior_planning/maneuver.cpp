@@ -0,0 +1,155 @@
+#include "maneuver.hpp"
+#include <algorithm>
+#include <cmath>
+
+#define LEAD_RANGE 80.0f    // meter
+
+ManeuverConfig default_maneuver_config()
+{
+    return {
+        .horizon=3.0f,
+        .dt=0.1f,
+        .min_accel=-6.0f,
+        .max_accel=2.0f,
+        .num_accels=9,
+        .aeb_accel=-5.0f,
+        .min_gap=5.0f,
+        .time_headway=1.0f,
+        .speed_weight=0.1f,
+        .accel_weight=0.5f,
+        .gap_weight=2.0f,
+        .lane_change_cost=20.0f,
+        .collision_cost=1.0e6f,
+    };
+}
+
+ManeuverPlanner::ManeuverPlanner(const ManeuverConfig& cfg, tp::ThreadPool* pool)
+    : cfg_(cfg)
+    , pool_(pool)
+{
+    const int n{std::max(1, cfg_.num_accels)};
+    for (int i = 0; i < n; ++i) {
+        const float ratio{n > 1 ? static_cast<float>(i) / (n - 1) : 1.0f};
+        accels_.push_back(cfg_.min_accel + ratio * (cfg_.max_accel - cfg_.min_accel));
+    }
+    candidates_.reserve(accels_.size() * 3);
+    costs_.reserve(accels_.size() * 3);
+}
+
+void ManeuverPlanner::plan(const VehModel& ego, const Scene& scene, BehaviorInfo& bi)
+{
+    generate(ego);
+    costs_.resize(candidates_.size());
+
+    // neighbors only depend on the lane, look them up once for all the profiles
+    for (int lane_id = 0; lane_id < NUM_LANES; ++lane_id) {
+        const auto& lane{scene.lane(lane_id)};
+        auto& nb{neighbors_[lane_id]};
+        nb.lead = scene.lead(lane_id, ego.position.x);
+        nb.follow = nb.lead < 0 ? static_cast<int>(lane.size()) - 1 : nb.lead - 1;
+    }
+
+    const int n{static_cast<int>(candidates_.size())};
+    if (pool_ != nullptr && pool_->size() > 1) {
+        const int grain{std::max(1, n / pool_->size())};
+        pool_->parallel_for(n, grain, [this, &ego, &scene](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                costs_[i] = evaluate(candidates_[i], ego, scene);
+            }
+        });
+    } else {
+        for (int i = 0; i < n; ++i) {
+            costs_[i] = evaluate(candidates_[i], ego, scene);
+        }
+    }
+
+    const auto best{std::min_element(costs_.begin(), costs_.end()) - costs_.begin()};
+    fill_info(candidates_[best], ego, scene, bi);
+}
+
+void ManeuverPlanner::generate(const VehModel& ego)
+{
+    candidates_.clear();
+    for (int lane_id = ego.lane_id - 1; lane_id <= ego.lane_id + 1; ++lane_id) {
+        if (lane_id < 0 || lane_id >= NUM_LANES) continue;
+        for (const float accel : accels_) {
+            candidates_.push_back({.lane_id=lane_id, .accel=accel});
+        }
+    }
+}
+
+float ManeuverPlanner::evaluate(const Maneuver& m, const VehModel& ego, const Scene& scene) const
+{
+    const auto& lane{scene.lane(m.lane_id)};
+    const int lead{neighbors_[m.lane_id].lead};
+    const int follow{neighbors_[m.lane_id].follow};
+
+    float cost{m.lane_id != ego.lane_id ? cfg_.lane_change_cost : 0.0f};
+    cost += cfg_.accel_weight * m.accel * m.accel;
+
+    // the sooner a collision the higher its cost, so that when every candidate
+    // collides the one putting it off the longest, braking hardest, wins
+    auto collision = [this](float t) { return cfg_.collision_cost * (2.0f - t / cfg_.horizon); };
+
+    VehModel sim{ego};
+    sim.accel = m.accel;
+    const int steps{static_cast<int>(cfg_.horizon / cfg_.dt + 0.5f)};
+    // step 0 checks the gaps as they are, a lane change takes the ego to the
+    // new lane at once
+    for (int i = 0; i <= steps; ++i) {
+        const float t{i * cfg_.dt};
+        if (i > 0) {
+            // the profile ends once the speed saturates
+            if ((sim.accel > 0.0f && sim.vel >= TARGET_SPD) || (sim.accel < 0.0f && sim.vel <= 0.0f)) {
+                sim.accel = 0.0f;
+            }
+            sim.step(cfg_.dt);
+            sim.vel = std::max(0.0f, sim.vel);
+            cost += cfg_.speed_weight * (TARGET_SPD - sim.vel) * (TARGET_SPD - sim.vel) * cfg_.dt;
+        }
+        if (lead >= 0) {
+            const float gap{lane.x[lead] + lane.vel[lead] * t - sim.position.x};
+            if (gap < cfg_.min_gap) return cost + collision(t);
+            const float safe{cfg_.min_gap + cfg_.time_headway * sim.vel};
+            if (gap < safe) cost += cfg_.gap_weight * (safe - gap) * (safe - gap) * cfg_.dt;
+        }
+        if (follow >= 0) {
+            const float follow_vel{lane.vel[follow]};
+            const float gap{sim.position.x - lane.x[follow] - follow_vel * t};
+            if (gap < cfg_.min_gap) return cost + collision(t);
+            const float safe{cfg_.min_gap + cfg_.time_headway * follow_vel};
+            if (gap < safe) cost += cfg_.gap_weight * (safe - gap) * (safe - gap) * cfg_.dt;
+        }
+    }
+    return cost;
+}
+
+void ManeuverPlanner::fill_info(const Maneuver& m, const VehModel& ego, const Scene& scene, BehaviorInfo& bi) const
+{
+    bi.lane_id = m.lane_id;
+    bi.accel = m.accel;
+    bi.lead_id = -1;
+
+    const int lead{neighbors_[m.lane_id].lead};
+    const auto& lane{scene.lane(m.lane_id)};
+    const bool has_lead{lead >= 0 && lane.x[lead] - ego.position.x < LEAD_RANGE};
+    if (has_lead) {
+        bi.lead_accel = lane.accel[lead];
+        bi.lead_id = lane.id[lead];
+        bi.lead_lane_id = m.lane_id;
+        bi.lead_position = {.x=lane.x[lead], .y=0.0f};
+        bi.lead_vel = lane.vel[lead];
+    }
+
+    if (m.lane_id > ego.lane_id) {
+        bi.behavior = BH_CHANGE_LEFT;
+    } else if (m.lane_id < ego.lane_id) {
+        bi.behavior = BH_CHANGE_RIGHT;
+    } else if (m.accel <= cfg_.aeb_accel) {
+        bi.behavior = BH_AEB;
+    } else if (has_lead) {
+        bi.behavior = BH_FOLLOW;
+    } else {
+        bi.behavior = BH_CRUISE;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef BEHAVIOR_PLANNING_MANEUVER_H_
+#define BEHAVIOR_PLANNING_MANEUVER_H_
+
+#include <vector>
+#include "scene.hpp"
+#include "thread_pool.hpp"
+#include "vehicle.hpp"
+
+struct ManeuverConfig
+{
+    float horizon;          // second, forward simulated for every candidate
+    float dt;               // second
+    float min_accel;        // m/s^2, the hardest braking profile
+    float max_accel;        // m/s^2
+    int num_accels;         // speed profiles per lane, evenly spaced in [min_accel, max_accel]
+    float aeb_accel;        // m/s^2, profiles braking at least that hard are AEB
+    float min_gap;          // meter, closer than that is a collision
+    float time_headway;     // second, desired gap on top of min_gap
+    float speed_weight;
+    float accel_weight;
+    float gap_weight;
+    float lane_change_cost;
+    float collision_cost;   // at the end of the horizon, twice that right away
+}; // struct ManeuverConfig
+
+struct Maneuver
+{
+    int lane_id;
+    float accel;            // m/s^2, held until the speed saturates
+}; // struct Maneuver
+
+// Generates a candidate for every reachable lane and speed profile, scores
+// each over a short horizon with VehModel::step against constant velocity
+// predictions of the neighbors and keeps the cheapest.
+class ManeuverPlanner
+{
+public:
+    // candidates are scored on the pool when one is given
+    ManeuverPlanner(const ManeuverConfig& cfg, tp::ThreadPool* pool);
+    ~ManeuverPlanner() = default;
+
+    void plan(const VehModel& ego, const Scene& scene, BehaviorInfo& bi);
+    inline size_t num_candidates() const { return candidates_.size(); }
+private:
+    void generate(const VehModel& ego);
+    float evaluate(const Maneuver& m, const VehModel& ego, const Scene& scene) const;
+    void fill_info(const Maneuver& m, const VehModel& ego, const Scene& scene, BehaviorInfo& bi) const;
+
+    // indices in each lane of the participants just ahead of and behind the ego, -1 if none
+    struct Neighbors
+    {
+        int lead;
+        int follow;
+    }; // struct Neighbors
+
+    ManeuverConfig cfg_;
+    tp::ThreadPool* pool_;
+    Neighbors neighbors_[NUM_LANES];
+    std::vector<float> accels_;
+    std::vector<Maneuver> candidates_;
+    std::vector<float> costs_;
+}; // class ManeuverPlanner
+
+ManeuverConfig default_maneuver_config();
+
+#endif // BEHAVIOR_PLANNING_MANEUVER_H_
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <vector>
+#include "maneuver.hpp"
+#include "scene.hpp"
+
+// Scenes with one right answer for the maneuver planner, exits non-zero if
+// it picks another one.
+//
+//   boxed in       a stopped car ahead too close to stop behind and cars
+//                  alongside in both other lanes, so every candidate
+//                  collides: brake as hard as possible in the own lane
+//   occupied gap   a slow car ahead, a car 4.5 m ahead in the left lane
+//                  pulling away and a stopped car in the right lane: the
+//                  left lane is already inside min_gap, stay and slow down
+//   closing in     a much faster car right behind in the own lane and free
+//                  lanes on both sides: get out of its way
+
+struct Participant
+{
+    int lane_id;
+    float x;        // meter, the ego is at 0
+    float vel;      // m/s
+}; // struct Participant
+
+static bool check(const char* name, const std::vector<Participant>& participants,
+    bool (*expected)(const BehaviorInfo&, const ManeuverConfig&))
+{
+    const auto cfg{default_maneuver_config()};
+    ManeuverPlanner planner{cfg, nullptr};
+
+    Scene scene;
+    for (size_t i = 0; i < participants.size(); ++i) {
+        const auto& p{participants[i]};
+        scene.add(static_cast<int>(i), p.lane_id, p.x, p.vel, 0.0f);
+    }
+
+    VehModel ego{.id=-1, .lane_id=1, .heading=0.0f, .accel=0.0f, .vel=20.0f, .position={.x=0.0f, .y=0.0f}};
+    BehaviorInfo bi;
+    planner.plan(ego, scene, bi);
+
+    const bool ok{expected(bi, cfg)};
+    std::cout << name << ": lane: " << bi.lane_id << ", accel: " << bi.accel
+              << ", behavior: " << stringify(bi.behavior) << (ok ? "" : " FAILED") << "\n";
+    return ok;
+}
+
+int main()
+{
+    bool ok{true};
+    ok &= check("boxed in", {{1, 15.0f, 0.0f}, {0, 0.5f, 20.0f}, {2, 0.5f, 20.0f}},
+        [](const BehaviorInfo& bi, const ManeuverConfig& cfg) { return bi.lane_id == 1 && bi.accel == cfg.min_accel; });
+    ok &= check("occupied gap", {{1, 25.0f, 5.0f}, {0, 10.0f, 0.0f}, {2, 4.5f, 60.0f}},
+        [](const BehaviorInfo& bi, const ManeuverConfig&) { return bi.lane_id == 1 && bi.accel < 0.0f; });
+    ok &= check("closing in", {{1, -8.0f, 40.0f}},
+        [](const BehaviorInfo& bi, const ManeuverConfig&) { return bi.lane_id != 1; });
+    return ok ? 0 : 1;
+}
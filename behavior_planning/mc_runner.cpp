@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "simulation.hpp"
+#include "thread_pool.hpp"
+
+#define TTC_BIN_SIZE    0.5f    // second
+#define TTC_BINS        20      // the last bin also counts scenarios never closer than that
+
+struct Options
+{
+    long scenarios;
+    long ticks;             // per scenario
+    int participants;
+    int threads;            // 0 uses every core
+    int grain;              // scenarios per task
+    uint64_t seed;
+}; // struct Options
+
+// Aggregated over scenarios, one per worker so nothing is shared while running
+struct alignas(64) Stats
+{
+    long scenarios;
+    long collisions;
+    long ticks;
+    long behavior[BH_CHANGE_RIGHT + 1];
+    long min_ttc[TTC_BINS];    // histogram of the smallest time-to-collision of each scenario
+
+    void merge(const Stats& other)
+    {
+        scenarios += other.scenarios;
+        collisions += other.collisions;
+        ticks += other.ticks;
+        for (int i = 0; i <= BH_CHANGE_RIGHT; ++i) behavior[i] += other.behavior[i];
+        for (int i = 0; i < TTC_BINS; ++i) min_ttc[i] += other.min_ttc[i];
+    }
+}; // struct Stats
+
+// seed of the i-th scenario, independent of which worker runs it
+inline unsigned int scenario_seed(uint64_t seed, uint64_t i)
+{
+    uint64_t z{seed + (i + 1) * 0x9e3779b97f4a7c15ull};
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<unsigned int>(z ^ (z >> 31));
+}
+
+void run_scenario(Simulation& sim, const Options& opts, long idx, Stats& stats)
+{
+    const SimConfig cfg{.num_participants=opts.participants, .dt=STEP_SIZE, .spawn_range=100.0f};
+    sim.reset(scenario_seed(opts.seed, idx), cfg);
+
+    BehaviorInfo bi;
+    float min_ttc{INFINITY};
+    bool collided{false};
+    while (sim.ticks() < opts.ticks) {
+        const int hit{sim.tick(bi)};
+        ++stats.behavior[bi.behavior];
+        min_ttc = std::min(min_ttc, time_to_collision(sim.ego(), bi));
+        if (hit >= 0) {
+            collided = true;
+            min_ttc = 0.0f;
+            break;
+        }
+    }
+
+    ++stats.scenarios;
+    stats.ticks += sim.ticks();
+    stats.collisions += collided;
+    const int bin{std::isinf(min_ttc) ? TTC_BINS - 1 : static_cast<int>(min_ttc / TTC_BIN_SIZE)};
+    ++stats.min_ttc[std::min(bin, TTC_BINS - 1)];
+}
+
+void usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [--scenarios N] [--ticks N] [--participants N]"
+              << " [--threads N] [--grain N] [--seed N]\n";
+}
+
+bool parse_options(int argc, char** argv, Options& opts)
+{
+    opts = {.scenarios=10000, .ticks=3000, .participants=10, .threads=0, .grain=16, .seed=0};
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--scenarios") == 0) {
+            opts.scenarios = std::atol(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--ticks") == 0) {
+            opts.ticks = std::atol(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--participants") == 0) {
+            opts.participants = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            opts.threads = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--grain") == 0) {
+            opts.grain = std::max(1, std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            opts.seed = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && opts.scenarios > 0 && opts.ticks > 0;
+}
+
+void report(const Stats& total, double wall)
+{
+    const double scenarios{static_cast<double>(total.scenarios)};
+    std::cout << std::fixed << std::setprecision(4)
+              << "== MONTE CARLO ==\n"
+              << " scenarios: " << total.scenarios << "\n"
+              << " ticks: " << total.ticks << "\n"
+              << " collisions: " << total.collisions
+              << " (rate " << total.collisions / scenarios << ")\n"
+              << " wall: " << wall << " s, " << scenarios / wall << " scenarios/s\n";
+
+    std::cout << "== MIN TTC ==\n";
+    for (int i = 0; i < TTC_BINS; ++i) {
+        if (total.min_ttc[i] == 0) continue;
+        std::cout << " [" << std::setw(5) << std::setprecision(1) << i * TTC_BIN_SIZE << ", ";
+        if (i + 1 < TTC_BINS) {
+            std::cout << std::setw(5) << (i + 1) * TTC_BIN_SIZE << ")";
+        } else {
+            std::cout << "  inf)";
+        }
+        std::cout << ": " << std::setprecision(4) << total.min_ttc[i] / scenarios << "\n";
+    }
+
+    std::cout << "== BEHAVIOR ==\n";
+    for (int b = 0; b <= BH_CHANGE_RIGHT; ++b) {
+        if (total.behavior[b] == 0) continue;
+        std::cout << " " << stringify(static_cast<Behavior>(b)) << ": "
+                  << static_cast<double>(total.behavior[b]) / total.ticks << "\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    tp::ThreadPool pool{opts.threads};
+    std::vector<Simulation> sims(pool.size());
+    std::vector<Stats> stats(pool.size(), Stats{});
+
+    const auto start{std::chrono::steady_clock::now()};
+    // scenarios end at different ticks on collision, idle workers steal the rest
+    for (long begin = 0; begin < opts.scenarios; begin += opts.grain) {
+        const long end{std::min(opts.scenarios, begin + opts.grain)};
+        pool.submit([&, begin, end](int worker) {
+            for (long i = begin; i < end; ++i) {
+                run_scenario(sims[worker], opts, i, stats[worker]);
+            }
+        });
+    }
+    pool.wait();
+    const std::chrono::duration<double> wall{std::chrono::steady_clock::now() - start};
+
+    Stats total{};
+    for (const auto& s : stats) {
+        total.merge(s);
+    }
+    report(total, wall.count());
+    return 0;
+}
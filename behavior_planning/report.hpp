@@ -0,0 +1,48 @@
+#ifndef BEHAVIOR_PLANNING_REPORT_H_
+#define BEHAVIOR_PLANNING_REPORT_H_
+
+#include <ostream>
+#include "vehicle.hpp"
+
+// One planning tick, cheap to copy into a RingBuffer
+struct TickReport
+{
+    long tick;
+    Behavior behavior;
+    int lane_id;
+    int lead_id;
+    float ego_x;
+    float ego_vel;
+    float ego_accel;
+    float lead_x;
+    float lead_vel;
+}; // struct TickReport
+
+inline TickReport make_report(long tick, const VehModel& ego, const BehaviorInfo& bi)
+{
+    const bool has_lead{bi.lead_id >= 0};
+    return {
+        .tick=tick,
+        .behavior=bi.behavior,
+        .lane_id=ego.lane_id,
+        .lead_id=has_lead ? bi.lead_id : -1,
+        .ego_x=ego.position.x,
+        .ego_vel=ego.vel,
+        .ego_accel=ego.accel,
+        .lead_x=has_lead ? bi.lead_position.x : 0.0f,
+        .lead_vel=has_lead ? bi.lead_vel : 0.0f,
+    };
+}
+
+inline std::ostream& operator<<(std::ostream& os, const TickReport& r)
+{
+    os << "tick: " << r.tick << ", behavior: " << stringify(r.behavior)
+       << ", lane id: " << r.lane_id << ", ego: " << r.ego_x
+       << ", vel: " << r.ego_vel << ", accel: " << r.ego_accel;
+    if (r.lead_id >= 0) {
+        os << ", lead id: " << r.lead_id << ", lead: " << r.lead_x << ", lead vel: " << r.lead_vel;
+    }
+    return os;
+}
+
+#endif // BEHAVIOR_PLANNING_REPORT_H_
@@ -0,0 +1,263 @@
+#include "scene.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <utility>
+
+#define LANE_CHANGE_PROB 0.02f  // per participant per step
+
+void LaneTraffic::push(int id_, float x_, float vel_, float accel_)
+{
+    id.push_back(id_);
+    x.push_back(x_);
+    vel.push_back(vel_);
+    accel.push_back(accel_);
+}
+
+void LaneTraffic::clear()
+{
+    id.clear();
+    x.clear();
+    vel.clear();
+    accel.clear();
+}
+
+void LaneTraffic::reserve(size_t n)
+{
+    id.reserve(n);
+    x.reserve(n);
+    vel.reserve(n);
+    accel.reserve(n);
+}
+
+void LaneTraffic::resize(size_t n)
+{
+    id.resize(n);
+    x.resize(n);
+    vel.resize(n);
+    accel.resize(n);
+}
+
+// move [begin, end) to start at `to`, with to <= begin
+static void move_range(LaneTraffic& lane, size_t begin, size_t end, size_t to)
+{
+    std::copy(lane.id.begin() + begin, lane.id.begin() + end, lane.id.begin() + to);
+    std::copy(lane.x.begin() + begin, lane.x.begin() + end, lane.x.begin() + to);
+    std::copy(lane.vel.begin() + begin, lane.vel.begin() + end, lane.vel.begin() + to);
+    std::copy(lane.accel.begin() + begin, lane.accel.begin() + end, lane.accel.begin() + to);
+}
+
+// move [begin, end) to start at `to`, with to >= begin
+static void move_range_backward(LaneTraffic& lane, size_t begin, size_t end, size_t to)
+{
+    const size_t to_end{to + end - begin};
+    std::copy_backward(lane.id.begin() + begin, lane.id.begin() + end, lane.id.begin() + to_end);
+    std::copy_backward(lane.x.begin() + begin, lane.x.begin() + end, lane.x.begin() + to_end);
+    std::copy_backward(lane.vel.begin() + begin, lane.vel.begin() + end, lane.vel.begin() + to_end);
+    std::copy_backward(lane.accel.begin() + begin, lane.accel.begin() + end, lane.accel.begin() + to_end);
+}
+
+void Scene::seed(unsigned int s)
+{
+    rng_.seed(s);
+}
+
+void Scene::add(int id, int lane_id, float x, float vel, float accel)
+{
+    assert(lane_id >= 0 && lane_id < NUM_LANES);
+    auto& lane{lanes_[lane_id]};
+    const auto pos{std::upper_bound(lane.x.begin(), lane.x.end(), x) - lane.x.begin()};
+    lane.id.insert(lane.id.begin() + pos, id);
+    lane.x.insert(lane.x.begin() + pos, x);
+    lane.vel.insert(lane.vel.begin() + pos, vel);
+    lane.accel.insert(lane.accel.begin() + pos, accel);
+}
+
+void Scene::load_lane(int lane_id, const int* id, const float* x, const float* vel, const float* accel, size_t n)
+{
+    assert(lane_id >= 0 && lane_id < NUM_LANES);
+    auto& lane{lanes_[lane_id]};
+    lane.id.assign(id, id + n);
+    lane.x.assign(x, x + n);
+    lane.vel.assign(vel, vel + n);
+    lane.accel.assign(accel, accel + n);
+}
+
+void Scene::clear()
+{
+    for (auto& lane : lanes_) {
+        lane.clear();
+    }
+}
+
+size_t Scene::size() const
+{
+    size_t n{0};
+    for (const auto& lane : lanes_) {
+        n += lane.size();
+    }
+    return n;
+}
+
+// the text form of a linear congruential engine is its state
+uint64_t Scene::rng_state() const
+{
+    std::stringstream ss;
+    ss << rng_;
+    uint64_t state{0};
+    ss >> state;
+    return state;
+}
+
+void Scene::set_rng_state(uint64_t state)
+{
+    std::stringstream ss;
+    ss << state;
+    ss >> rng_;
+}
+
+void Scene::step(float dt, float ego_x)
+{
+    const float half_dt2{0.5f * dt * dt};
+    for (auto& lane : lanes_) {
+        const size_t n{lane.size()};
+        float* __restrict x{lane.x.data()};
+        float* __restrict vel{lane.vel.data()};
+        const float* __restrict accel{lane.accel.data()};
+        for (size_t i = 0; i < n; ++i) {
+            x[i] += vel[i] * dt + accel[i] * half_dt2;
+            vel[i] += accel[i] * dt;
+        }
+
+        perturb(lane);
+        sort_lane(lane);
+    }
+    change_lanes(ego_x);
+}
+
+int Scene::lead(int lane_id, float x) const
+{
+    const auto& lane{lanes_[lane_id]};
+    const auto it{std::lower_bound(lane.x.begin(), lane.x.end(), x)};
+    if (it == lane.x.end()) return -1;
+    return static_cast<int>(it - lane.x.begin());
+}
+
+int Scene::collision(int lane_id, float x, float vel) const
+{
+    const auto& lane{lanes_[lane_id]};
+    const auto n{lane.size()};
+    auto i{static_cast<size_t>(std::upper_bound(lane.x.begin(), lane.x.end(), x) - lane.x.begin())};
+    for (; i < n && lane.x[i] - x < 5.0f; ++i) {
+        if (lane.vel[i] > vel) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// stateless integer hash, lets the noise of every participant be drawn independently
+static inline uint32_t hash32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+void Scene::perturb(LaneTraffic& lane)
+{
+    constexpr float to_unit{1.0f / 16777216.0f};  // 2^-24
+
+    const uint32_t base{static_cast<uint32_t>(rng_())};
+    const uint32_t n{static_cast<uint32_t>(lane.size())};
+    const float* __restrict vel{lane.vel.data()};
+    float* __restrict accel{lane.accel.data()};
+    for (uint32_t i = 0; i < n; ++i) {
+        const float noise{static_cast<float>(static_cast<int32_t>(hash32(base + i) >> 8)) * to_unit * 0.2f - 0.1f};
+        accel[i] += vel[i] > 10.0f ? noise : 0.1f;
+    }
+}
+
+void Scene::sort_lane(LaneTraffic& lane)
+{
+    // the lane stays almost sorted between steps, insertion sort is linear then
+    const size_t n{lane.size()};
+    for (size_t i = 1; i < n; ++i) {
+        if (lane.x[i - 1] <= lane.x[i]) continue;
+
+        const int id{lane.id[i]};
+        const float x{lane.x[i]};
+        const float vel{lane.vel[i]};
+        const float accel{lane.accel[i]};
+        size_t j{i};
+        for (; j > 0 && lane.x[j - 1] > x; --j) {
+            lane.id[j] = lane.id[j - 1];
+            lane.x[j] = lane.x[j - 1];
+            lane.vel[j] = lane.vel[j - 1];
+            lane.accel[j] = lane.accel[j - 1];
+        }
+        lane.id[j] = id;
+        lane.x[j] = x;
+        lane.vel[j] = vel;
+        lane.accel[j] = accel;
+    }
+}
+
+void Scene::change_lanes(float ego_x)
+{
+    for (int l = 0; l < NUM_LANES; ++l) {
+        auto& lane{lanes_[l]};
+        auto& target{incoming_[(l + 1) % NUM_LANES]};
+        target.clear();
+        movers_.clear();
+        for (size_t i = skip_to_change(); i < lane.size(); i += 1 + skip_to_change()) {
+            if (abs(lane.x[i] - ego_x) > 5.0f) {
+                movers_.push_back(i);
+                target.push(lane.id[i], lane.x[i], lane.vel[i], lane.accel[i]);
+            }
+        }
+        if (movers_.empty()) continue;
+
+        // close the gaps left by the movers
+        size_t w{movers_.front()};
+        for (size_t k = 0; k < movers_.size(); ++k) {
+            const size_t begin{movers_[k] + 1};
+            const size_t end{k + 1 < movers_.size() ? movers_[k + 1] : lane.size()};
+            move_range(lane, begin, end, w);
+            w += end - begin;
+        }
+        lane.resize(w);
+    }
+
+    // movers come from a single sorted lane, merge them in from the back
+    for (int l = 0; l < NUM_LANES; ++l) {
+        const auto& in{incoming_[l]};
+        if (in.size() == 0) continue;
+
+        auto& lane{lanes_[l]};
+        size_t end{lane.size()};
+        lane.resize(lane.size() + in.size());
+        size_t w{lane.size()};
+        for (size_t j = in.size(); j-- > 0;) {
+            const auto pos{static_cast<size_t>(
+                std::upper_bound(lane.x.begin(), lane.x.begin() + end, in.x[j]) - lane.x.begin())};
+            w -= end - pos;
+            move_range_backward(lane, pos, end, w);
+            end = pos;
+            --w;
+            lane.id[w] = in.id[j];
+            lane.x[w] = in.x[j];
+            lane.vel[w] = in.vel[j];
+            lane.accel[w] = in.accel[j];
+        }
+    }
+}
+
+size_t Scene::skip_to_change()
+{
+    // geometric number of participants staying in lane before the next change
+    static const float log_stay{std::log(1.0f - LANE_CHANGE_PROB)};
+    const float u{std::max(uniform01(), 1.0e-7f)};
+    return static_cast<size_t>(std::log(u) / log_stay);
+}
@@ -0,0 +1,68 @@
+#ifndef BEHAVIOR_PLANNING_SCENE_H_
+#define BEHAVIOR_PLANNING_SCENE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "vehicle.hpp"
+
+// Participants of one lane as parallel arrays, sorted by x ascending
+struct LaneTraffic
+{
+    std::vector<int> id;
+    std::vector<float> x;
+    std::vector<float> vel;
+    std::vector<float> accel;
+
+    inline size_t size() const { return x.size(); }
+    void push(int id, float x, float vel, float accel);
+    void clear();
+    void reserve(size_t n);
+    void resize(size_t n);
+}; // struct LaneTraffic
+
+class Scene
+{
+public:
+    Scene() = default;
+    ~Scene() = default;
+
+    void seed(unsigned int s);
+    void add(int id, int lane_id, float x, float vel, float accel);
+    // replace a lane with arrays already sorted by x
+    void load_lane(int lane_id, const int* id, const float* x, const float* vel, const float* accel, size_t n);
+    void clear();
+    // advance every participant by dt, those farther than 5 m from ego_x may change lane
+    void step(float dt, float ego_x);
+
+    // index of the nearest participant in the lane at or ahead of x, -1 if none
+    int lead(int lane_id, float x) const;
+    // index of a participant the ego at (lane_id, x, vel) is colliding with, -1 if none
+    int collision(int lane_id, float x, float vel) const;
+
+    inline const LaneTraffic& lane(int lane_id) const { return lanes_[lane_id]; }
+    size_t size() const;
+    // state of the generator behind step(), restored along with the lanes the
+    // scene takes the same steps again
+    uint64_t rng_state() const;
+    void set_rng_state(uint64_t state);
+private:
+    void perturb(LaneTraffic& lane);
+    void sort_lane(LaneTraffic& lane);
+    void change_lanes(float ego_x);
+    size_t skip_to_change();
+    inline float uniform01()
+    {
+        return static_cast<float>(rng_() - rng_.min()) / static_cast<float>(rng_.max() - rng_.min());
+    }
+
+    LaneTraffic lanes_[NUM_LANES];
+    std::minstd_rand rng_;
+
+    // scratch buffers reused by every step
+    LaneTraffic incoming_[NUM_LANES];
+    std::vector<size_t> movers_;
+}; // class Scene
+
+#endif // BEHAVIOR_PLANNING_SCENE_H_
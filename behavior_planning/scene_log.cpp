@@ -0,0 +1,299 @@
+#include "scene_log.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_FLUSH_SIZE (1 << 20)    // bytes
+
+static_assert(std::is_trivially_copyable<LogTickHeader>::value, "log records are copied as raw bytes");
+
+static inline size_t padded(size_t n)
+{
+    return (n + 7) & ~static_cast<size_t>(7);
+}
+
+static size_t record_size(const uint32_t* lane_size)
+{
+    size_t n{sizeof(LogTickHeader)};
+    // lane_size is 0 unless on keyframes
+    for (int l = 0; l < NUM_LANES; ++l) {
+        n += lane_size[l] * (sizeof(int) + 3 * sizeof(float));
+    }
+    return padded(n);
+}
+
+SceneLogWriter::SceneLogWriter()
+    : fp_(nullptr)
+    , bytes_(0)
+    , keyframe_interval_(SCENE_LOG_KEYFRAME_INTERVAL)
+    , num_records_(0)
+    , back_ready_(false)
+    , stop_(false)
+    , failed_(false)
+{}
+
+SceneLogWriter::~SceneLogWriter()
+{
+    close();
+}
+
+bool SceneLogWriter::open(const char* path, uint32_t seed, float dt, uint32_t keyframe_interval)
+{
+    close();
+    fp_ = std::fopen(path, "wb");
+    if (fp_ == nullptr) return false;
+    keyframe_interval_ = std::max(1u, keyframe_interval);
+    num_records_ = 0;
+
+    const LogFileHeader header{
+        .magic={'B', 'P', 'L', 'G'},
+        .version=SCENE_LOG_VERSION,
+        .seed=seed,
+        .dt=dt,
+        .num_lanes=NUM_LANES,
+        .keyframe_interval=keyframe_interval_
+    };
+    front_.reserve(2 * LOG_FLUSH_SIZE);
+    back_.reserve(2 * LOG_FLUSH_SIZE);
+    append(&header, sizeof(header));
+    bytes_ = sizeof(header);
+
+    stop_ = false;
+    back_ready_ = false;
+    failed_ = false;
+    thread_ = std::thread{[this]() { flush_loop(); }};
+    return true;
+}
+
+void SceneLogWriter::record(long tick, const VehModel& ego, const Scene& scene, const BehaviorInfo& bi)
+{
+    if (fp_ == nullptr) return;
+
+    LogTickHeader header{};
+    header.keyframe = num_records_++ % keyframe_interval_ == 0;
+    if (header.keyframe) {
+        for (int l = 0; l < NUM_LANES; ++l) {
+            header.lane_size[l] = static_cast<uint32_t>(scene.lane(l).size());
+        }
+        header.rng_state = scene.rng_state();
+    }
+    header.size = static_cast<uint32_t>(record_size(header.lane_size));
+    header.tick = tick;
+    header.ego = ego;
+    header.bi = bi;
+
+    const size_t start{front_.size()};
+    append(&header, sizeof(header));
+    if (header.keyframe) {
+        for (int l = 0; l < NUM_LANES; ++l) {
+            const auto& lane{scene.lane(l)};
+            append(lane.id.data(), lane.size() * sizeof(int));
+            append(lane.x.data(), lane.size() * sizeof(float));
+            append(lane.vel.data(), lane.size() * sizeof(float));
+            append(lane.accel.data(), lane.size() * sizeof(float));
+        }
+    }
+    front_.resize(start + header.size, 0);
+    bytes_ += header.size;
+
+    if (front_.size() >= LOG_FLUSH_SIZE) {
+        hand_over();
+    }
+}
+
+bool SceneLogWriter::close()
+{
+    if (fp_ == nullptr) return true;
+
+    hand_over();
+    {
+        std::lock_guard<std::mutex> lock{mtx_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    const bool ok{std::fclose(fp_) == 0 && !failed_};
+    fp_ = nullptr;
+    return ok;
+}
+
+void SceneLogWriter::append(const void* data, size_t size)
+{
+    const char* p{static_cast<const char*>(data)};
+    front_.insert(front_.end(), p, p + size);
+}
+
+void SceneLogWriter::hand_over()
+{
+    if (front_.empty()) return;
+
+    std::unique_lock<std::mutex> lock{mtx_};
+    // only blocks when the disk is slower than the simulation
+    cv_.wait(lock, [this]() { return !back_ready_; });
+    std::swap(front_, back_);
+    back_ready_ = true;
+    lock.unlock();
+    cv_.notify_all();
+    front_.clear();
+}
+
+void SceneLogWriter::flush_loop()
+{
+    std::unique_lock<std::mutex> lock{mtx_};
+    while (true) {
+        cv_.wait(lock, [this]() { return back_ready_ || stop_; });
+        if (back_ready_) {
+            const bool skip{failed_};
+            lock.unlock();
+            // after a failure the buffers are still drained so record() never blocks
+            const bool ok{skip || std::fwrite(back_.data(), 1, back_.size(), fp_) == back_.size()};
+            back_.clear();
+            lock.lock();
+            failed_ = failed_ || !ok;
+            back_ready_ = false;
+            cv_.notify_all();
+        } else if (stop_) {
+            break;
+        }
+    }
+    if (std::fflush(fp_) != 0) failed_ = true;
+}
+
+SceneLogReader::SceneLogReader()
+    : fd_(-1)
+    , data_(nullptr)
+    , length_(0)
+    , header_{}
+    , scene_record_(-1)
+{}
+
+SceneLogReader::~SceneLogReader()
+{
+    close();
+}
+
+bool SceneLogReader::open(const char* path)
+{
+    close();
+    fd_ = ::open(path, O_RDONLY);
+    if (fd_ < 0) return false;
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(LogFileHeader)) {
+        close();
+        return false;
+    }
+    length_ = st.st_size;
+    void* addr{mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd_, 0)};
+    if (addr == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data_ = static_cast<const char*>(addr);
+
+    std::memcpy(&header_, data_, sizeof(header_));
+    if (std::memcmp(header_.magic, "BPLG", 4) != 0 || header_.version != SCENE_LOG_VERSION ||
+        header_.num_lanes != NUM_LANES) {
+        close();
+        return false;
+    }
+
+    // index the records, a truncated last record is dropped
+    size_t offset{sizeof(LogFileHeader)};
+    while (offset + sizeof(LogTickHeader) <= length_) {
+        uint32_t size;
+        std::memcpy(&size, data_ + offset, sizeof(size));
+        if (size < sizeof(LogTickHeader) || offset + size > length_) break;
+        uint32_t keyframe;
+        std::memcpy(&keyframe, data_ + offset + offsetof(LogTickHeader, keyframe), sizeof(keyframe));
+        if (keyframe != 0) keyframes_.push_back(offsets_.size());
+        offsets_.push_back(offset);
+        offset += size;
+    }
+    // the ticks before the first keyframe could not be restored
+    if (!offsets_.empty() && (keyframes_.empty() || keyframes_.front() != 0)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SceneLogReader::close()
+{
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), length_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    length_ = 0;
+    offsets_.clear();
+    keyframes_.clear();
+    scene_record_ = -1;
+}
+
+long SceneLogReader::find(long tick) const
+{
+    // ticks are logged in increasing order
+    const auto it{std::lower_bound(offsets_.begin(), offsets_.end(), tick, [this](size_t offset, long t) {
+        int64_t this_tick;
+        std::memcpy(&this_tick, data_ + offset + offsetof(LogTickHeader, tick), sizeof(this_tick));
+        return this_tick < t;
+    })};
+    if (it == offsets_.end()) return -1;
+
+    LogTickHeader header;
+    std::memcpy(&header, data_ + *it, sizeof(header));
+    return header.tick == tick ? static_cast<long>(it - offsets_.begin()) : -1;
+}
+
+LogTickHeader SceneLogReader::tick_header(size_t i) const
+{
+    LogTickHeader header;
+    std::memcpy(&header, data_ + offsets_.at(i), sizeof(header));
+    return header;
+}
+
+void SceneLogReader::load_keyframe(size_t i)
+{
+    const LogTickHeader header{tick_header(i)};
+    const char* p{data_ + offsets_[i] + sizeof(header)};
+    for (int l = 0; l < NUM_LANES; ++l) {
+        const size_t n{header.lane_size[l]};
+        const char* id{p};
+        const char* x{id + n * sizeof(int)};
+        const char* vel{x + n * sizeof(float)};
+        const char* accel{vel + n * sizeof(float)};
+        scene_.load_lane(l, reinterpret_cast<const int*>(id), reinterpret_cast<const float*>(x),
+            reinterpret_cast<const float*>(vel), reinterpret_cast<const float*>(accel), n);
+        p = accel + n * sizeof(float);
+    }
+    scene_.set_rng_state(header.rng_state);
+    scene_record_ = static_cast<long>(i);
+}
+
+void SceneLogReader::load(size_t i, long& tick, VehModel& ego, Scene& scene, BehaviorInfo& bi)
+{
+    const LogTickHeader header{tick_header(i)};
+    tick = header.tick;
+    ego = header.ego;
+    bi = header.bi;
+
+    // the scene of record r + 1 is that of r stepped at the ego position of r + 1
+    const size_t keyframe{*(std::upper_bound(keyframes_.begin(), keyframes_.end(), i) - 1)};
+    if (scene_record_ < static_cast<long>(keyframe) || scene_record_ > static_cast<long>(i)) {
+        load_keyframe(keyframe);
+    }
+    while (scene_record_ < static_cast<long>(i)) {
+        ++scene_record_;
+        scene_.step(header_.dt, tick_header(scene_record_).ego.position.x);
+    }
+    scene = scene_;
+}
@@ -0,0 +1,114 @@
+#ifndef BEHAVIOR_PLANNING_SCENE_LOG_H_
+#define BEHAVIOR_PLANNING_SCENE_LOG_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "scene.hpp"
+#include "vehicle.hpp"
+
+// Binary scene log, little endian, native float layout:
+//   LogFileHeader, then one record per tick:
+//   LogTickHeader, then on keyframes only, for every lane its id[n], x[n],
+//   vel[n] and accel[n] arrays, zero padded to 8 bytes.
+// The first tick and every keyframe_interval-th after it are keyframes. The
+// scene of the ticks in between is not copied, Scene::step is deterministic
+// so the reader steps the last keyframe forward with the logged ego.
+
+#define SCENE_LOG_VERSION           2
+#define SCENE_LOG_KEYFRAME_INTERVAL 1000    // ticks
+
+struct LogFileHeader
+{
+    char magic[4];          // "BPLG"
+    uint32_t version;
+    uint32_t seed;
+    float dt;               // second
+    uint32_t num_lanes;
+    uint32_t keyframe_interval; // ticks
+}; // struct LogFileHeader
+
+struct LogTickHeader
+{
+    uint32_t size;          // bytes of the whole record
+    uint32_t keyframe;      // 1 if the lane arrays follow
+    uint32_t lane_size[NUM_LANES];  // 0 unless keyframe
+    int64_t tick;
+    uint64_t rng_state;     // Scene::rng_state() on keyframes
+    VehModel ego;           // as seen by the planner, before acting
+    BehaviorInfo bi;        // what the planner chose
+}; // struct LogTickHeader
+
+// Appends ticks to an in-memory buffer, full buffers are written out by a
+// background thread so the simulation never waits on the disk. Only
+// keyframes copy the scene, the other ticks cost a LogTickHeader. A failed
+// write drops the rest of the log and is reported by close().
+class SceneLogWriter
+{
+public:
+    SceneLogWriter();
+    ~SceneLogWriter();
+    SceneLogWriter(const SceneLogWriter&) = delete;
+    SceneLogWriter& operator=(const SceneLogWriter&) = delete;
+
+    bool open(const char* path, uint32_t seed, float dt, uint32_t keyframe_interval = SCENE_LOG_KEYFRAME_INTERVAL);
+    void record(long tick, const VehModel& ego, const Scene& scene, const BehaviorInfo& bi);
+    // false if any write failed
+    bool close();
+    inline size_t bytes() const { return bytes_; }
+private:
+    void append(const void* data, size_t size);
+    void hand_over();
+    void flush_loop();
+
+    FILE* fp_;
+    size_t bytes_;
+    uint32_t keyframe_interval_;
+    long num_records_;
+    std::vector<char> front_;   // filled by the simulation thread
+    std::vector<char> back_;    // drained by the writer thread
+    bool back_ready_;
+    bool stop_;
+    bool failed_;               // set by the writer thread
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread thread_;
+}; // class SceneLogWriter
+
+// Memory maps a log and restores the snapshot of any tick, stepping the
+// scene from the last keyframe. In order loads step once per tick.
+class SceneLogReader
+{
+public:
+    SceneLogReader();
+    ~SceneLogReader();
+    SceneLogReader(const SceneLogReader&) = delete;
+    SceneLogReader& operator=(const SceneLogReader&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    inline size_t size() const { return offsets_.size(); }
+    inline const LogFileHeader& header() const { return header_; }
+    // record index of the tick, -1 if it was not logged
+    long find(long tick) const;
+    void load(size_t i, long& tick, VehModel& ego, Scene& scene, BehaviorInfo& bi);
+private:
+    LogTickHeader tick_header(size_t i) const;
+    void load_keyframe(size_t i);
+
+    int fd_;
+    const char* data_;
+    size_t length_;
+    LogFileHeader header_;
+    std::vector<size_t> offsets_;
+    std::vector<size_t> keyframes_;     // record indices
+    Scene scene_;                       // at record scene_record_
+    long scene_record_;
+}; // class SceneLogReader
+
+#endif // BEHAVIOR_PLANNING_SCENE_LOG_H_
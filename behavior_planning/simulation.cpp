@@ -0,0 +1,51 @@
+#include "simulation.hpp"
+
+Simulation::Simulation(tp::ThreadPool* pool)
+    : cfg_{.num_participants=0, .dt=STEP_SIZE, .spawn_range=100.0f}
+    , ego_{}
+    , planner_(default_maneuver_config(), pool)
+    , log_(nullptr)
+    , next_id_(0)
+    , ticks_(0)
+{}
+
+void Simulation::reset(unsigned int seed, const SimConfig& cfg)
+{
+    cfg_ = cfg;
+    rng_.seed(seed);
+    scene_.clear();
+    scene_.seed(rng_());
+    next_id_ = 0;
+    ticks_ = 0;
+
+    ego_ = VehModel{};
+    ego_.lane_id = 1;
+    ego_.id = gen_id();
+    ego_.vel = 20.0f;
+
+    std::uniform_int_distribution<int> lane_dist{0, NUM_LANES - 1};
+    for (int i = 0; i < cfg_.num_participants; ++i) {
+        const int lane_id{lane_dist(rng_)};
+        const float x{rand_ab(rng_, -10.0f, cfg_.spawn_range)};
+        const float vel{rand_ab(rng_, 10.0f, 40.0f)};
+        if (lane_id == ego_.lane_id && abs(x - ego_.position.x) < 5.0f) {
+            continue;
+        }
+        scene_.add(gen_id(), lane_id, x, vel, 0.0f);
+    }
+}
+
+int Simulation::tick(BehaviorInfo& bi)
+{
+    Control control;
+    ego_.step(cfg_.dt);
+    scene_.step(cfg_.dt, ego_.position.x);
+    ego_.behavior_plan(scene_, planner_, bi);
+    if (log_ != nullptr) {
+        log_->record(ticks_, ego_, scene_, bi);
+    }
+    ego_.vel_plan(bi, control);
+    ego_.act(control);
+    ++ticks_;
+    return scene_.collision(ego_.lane_id, ego_.position.x, ego_.vel);
+}
@@ -0,0 +1,59 @@
+#ifndef BEHAVIOR_PLANNING_SIMULATION_H_
+#define BEHAVIOR_PLANNING_SIMULATION_H_
+
+#include <cmath>
+#include <random>
+#include "maneuver.hpp"
+#include "scene.hpp"
+#include "scene_log.hpp"
+#include "vehicle.hpp"
+
+struct SimConfig
+{
+    int num_participants;
+    float dt;               // second
+    float spawn_range;      // meter, participants start in [-10, spawn_range] around the ego
+}; // struct SimConfig
+
+// One self-contained scenario: its own random generator, scene and ego,
+// several of them can run side by side on different threads.
+class Simulation
+{
+public:
+    // the ego planner scores its candidates on the pool when one is given
+    explicit Simulation(tp::ThreadPool* pool = nullptr);
+    ~Simulation() = default;
+
+    void reset(unsigned int seed, const SimConfig& cfg);
+    // every following tick is recorded to the log, nullptr stops recording
+    inline void set_log(SceneLogWriter* log) { log_ = log; }
+    // step the world, then plan and act the ego,
+    // returns the index in the ego lane of the participant hit, -1 if none
+    int tick(BehaviorInfo& bi);
+
+    inline const Scene& scene() const { return scene_; }
+    inline const VehModel& ego() const { return ego_; }
+    inline long ticks() const { return ticks_; }
+private:
+    inline int gen_id() { return (next_id_++ % 100000); }
+
+    SimConfig cfg_;
+    std::mt19937 rng_;
+    Scene scene_;
+    VehModel ego_;
+    ManeuverPlanner planner_;
+    SceneLogWriter* log_;
+    int next_id_;
+    long ticks_;
+}; // class Simulation
+
+// time until the ego reaches the lead at the current speeds, INFINITY if not closing in
+inline float time_to_collision(const VehModel& ego, const BehaviorInfo& bi)
+{
+    if (bi.lead_id < 0 || bi.lead_lane_id != ego.lane_id || ego.vel <= bi.lead_vel) {
+        return INFINITY;
+    }
+    return (bi.lead_position.x - ego.position.x) / (ego.vel - bi.lead_vel);
+}
+
+#endif // BEHAVIOR_PLANNING_SIMULATION_H_
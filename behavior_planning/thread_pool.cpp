@@ -0,0 +1,2 @@
+#define THREAD_POOL_IMPLEMENTATION
+#include "thread_pool.hpp"
@@ -0,0 +1,23 @@
+#include "vehicle.hpp"
+#include "maneuver.hpp"
+#include "scene.hpp"
+
+void VehModel::act(const Control& control)
+{
+    lane_id = control.lane_id;
+    accel = control.accel;
+}
+
+void VehModel::behavior_plan(const Scene& scene, ManeuverPlanner& planner, BehaviorInfo& bi)
+{
+    planner.plan(*this, scene, bi);
+}
+
+void VehModel::vel_plan(const BehaviorInfo& bi, Control& control)
+{
+    control.lane_id = bi.lane_id;
+    control.accel = bi.accel;
+    if (vel < 0.001f && control.accel < 0.0f) {
+        control.accel = 0.0f;
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef BEHAVIOR_PLANNING_VEHICLE_H_
+#define BEHAVIOR_PLANNING_VEHICLE_H_
+
+#include <cassert>
+#include <cstdlib>
+#include <ostream>
+#include <random>
+#include <string>
+#include "integrator.hpp"
+
+#define NUM_LANES 3
+#define TARGET_SPD 30.0f // mps
+#define STEP_SIZE 0.02f
+
+enum Behavior {
+    BH_UNKNOWN = 0,
+    BH_CRUISE,
+    BH_FOLLOW,
+    BH_AEB,
+    BH_COMFORT_STOP,
+    BH_CHANGE_LEFT,
+    BH_CHANGE_RIGHT,
+}; // enum Behavior
+
+inline const std::string& stringify(Behavior b)
+{
+    static std::string bh_unknown{"UNKNOWN"};
+    static std::string bh_cruise{"CRUISE"};
+    static std::string bh_follow{"FOLLOW"};
+    static std::string bh_aeb{"AEB"};
+    static std::string bh_comfort_stop{"COMFORT_STOP"};
+    static std::string bh_change_left{"CHANGE_LEFT"};
+    static std::string bh_change_right{"CHANGE_RIGHT"};
+
+    switch (b) {
+    case BH_UNKNOWN: return bh_unknown;
+    case BH_CRUISE: return bh_cruise;
+    case BH_FOLLOW: return bh_follow;
+    case BH_AEB: return bh_aeb;
+    case BH_COMFORT_STOP: return bh_comfort_stop;
+    case BH_CHANGE_LEFT: return bh_change_left;
+    case BH_CHANGE_RIGHT: return bh_change_right;
+    }
+    return bh_unknown;
+}
+
+template<typename Rng>
+inline float rand_ab(Rng& rng, float a, float b)
+{
+    assert(b > a);
+    return std::uniform_real_distribution<float>{a, b}(rng);
+}
+
+template<typename T>
+inline T abs(T v) { return v > 0 ? v : -v; }
+
+struct Vec2
+{
+    float x;
+    float y;
+}; // struct Vec2
+
+struct Control
+{
+    int lane_id;
+    float accel;
+}; // struct Control
+
+inline std::ostream& operator<<(std::ostream& os, const Vec2& v)
+{
+    os << "(" << v.x << ", " << v.y << ")";
+    return os;
+}
+
+struct BehaviorInfo
+{
+    int lane_id;
+    int lead_id;
+    int lead_lane_id;
+    float lead_vel;
+    float lead_accel;
+    Vec2 lead_position;
+    float accel;        // planned ego accel
+    Behavior behavior;
+}; // struct BehaviorInfo
+
+class Scene;
+class ManeuverPlanner;
+
+struct VehModel
+{
+    int id;
+    int lane_id;
+    float heading;
+    float accel;
+    float vel;
+    Vec2 position;
+
+    void step(float dt);
+    void act(const Control& control);
+    void behavior_plan(const Scene& scene, ManeuverPlanner& planner, BehaviorInfo& bi);
+    void vel_plan(const BehaviorInfo& bi, Control& control);
+}; // struct VehModel
+
+inline void VehModel::step(float dt)
+{
+    integ::longitudinal(position.x, vel, accel, dt);
+}
+
+#endif // BEHAVIOR_PLANNING_VEHICLE_H_
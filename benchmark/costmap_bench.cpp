@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+#define THREAD_POOL_IMPLEMENTATION
+#include "thread_pool.hpp"
+#include "costmap.hpp"
+
+// Costmap checks, then timings. The distances of small random maps are
+// compared with a brute-force search, after construction and after random
+// incremental updates, and the costs after the updates with a full update.
+// Exits non-zero on any mismatch, timings never fail.
+
+#define CHECK_MAPS          6
+#define CHECK_UPDATES       20      // incremental updates per map
+#define DISTANCE_TOLERANCE  1.0e-4f // meter
+#define BENCH_RESOLUTION    0.05f   // meter
+#define BENCH_UPDATES       100
+#define BENCH_UPDATE_CELLS  40      // side of an incrementally updated square, 2 m
+
+struct Options
+{
+    int size;           // cells per side of the timed map
+    int threads;        // pool size of the timed map
+    unsigned int seed;
+}; // struct Options
+
+bool parse_options(int argc, char** argv, Options& opts)
+{
+    opts = {.size=4096, .threads=static_cast<int>(std::max(1u, std::thread::hardware_concurrency())), .seed=1};
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--size") == 0 && has_value) {
+            opts.size = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            opts.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            opts.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return opts.size > 2 * BENCH_UPDATE_CELLS;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+}
+
+// distance from cell (r, c) to the nearest occupied cell, clamped to max_distance
+static float brute_force_distance(const DenseMap& map, int r, int c, float x_res, float y_res, float max_distance)
+{
+    const int reach_r{static_cast<int>(max_distance / x_res) + 2};
+    const int reach_c{static_cast<int>(max_distance / y_res) + 2};
+    float best{max_distance};
+    for (int rr = std::max(0, r - reach_r); rr < std::min(map.row, r + reach_r + 1); ++rr) {
+        for (int cc = std::max(0, c - reach_c); cc < std::min(map.col, c + reach_c + 1); ++cc) {
+            if (map.grid_status[rr * map.col + cc] > 0) {
+                best = std::min(best, std::hypot((rr - r) * x_res, (cc - c) * y_res));
+            }
+        }
+    }
+    return best;
+}
+
+// cells whose distance differs from the brute-force one
+static int distance_mismatches(const Costmap& cm, float x_res, float y_res)
+{
+    const DenseMap& map{cm.map()};
+    int mismatches{0};
+    for (int r = 0; r < map.row; ++r) {
+        for (int c = 0; c < map.col; ++c) {
+            const float expected{brute_force_distance(map, r, c, x_res, y_res, cm.config().max_distance)};
+            if (std::abs(expected - cm.distances()[r * map.col + c]) > DISTANCE_TOLERANCE) ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+// odd maps have anisotropic cells, the first half a max_distance of a few cells
+static bool check(std::mt19937& rng)
+{
+    bool ok{true};
+    for (int i = 0; i < CHECK_MAPS; ++i) {
+        const int row{37 + i * 13};
+        const int col{53 + i * 7};
+        const float x_res{i % 2 == 0 ? 0.1f : 0.2f};
+        const float y_res{0.1f};
+        const float max_distance{i < CHECK_MAPS / 2 ? 1.0f : 100.0f};
+        MapGen gen{0.0f, row * x_res, 0.0f, col * y_res, row, col};
+        DenseMap& map{gen.map};
+        for (auto& status : map.grid_status) status = rng() % 100 < 3;
+
+        tp::ThreadPool pool{i % 2 == 0 ? 1 : 3};
+        Costmap cm{map, {
+            .max_distance=max_distance,
+            .inscribed_radius=0.3f,
+            .inflation_radius=std::min(max_distance, 1.0f),
+            .cost_scaling=3.0f
+        }, i >= 2 ? &pool : nullptr};
+        const int built{distance_mismatches(cm, x_res, y_res)};
+
+        for (int u = 0; u < CHECK_UPDATES; ++u) {
+            const int r0{static_cast<int>(rng() % row)};
+            const int c0{static_cast<int>(rng() % col)};
+            const int r1{std::min(row, r0 + 1 + static_cast<int>(rng() % 6))};
+            const int c1{std::min(col, c0 + 1 + static_cast<int>(rng() % 6))};
+            for (int r = r0; r < r1; ++r) {
+                for (int c = c0; c < c1; ++c) {
+                    map.grid_status[r * col + c] = rng() % 2;
+                }
+            }
+            cm.update(r0, r1, c0, c1);
+        }
+        const int updated{distance_mismatches(cm, x_res, y_res)};
+        const std::vector<uint8_t> incremental{cm.costs()};
+        cm.update();
+        const int costs{static_cast<int>(std::inner_product(incremental.begin(), incremental.end(),
+            cm.costs().begin(), 0, std::plus<int>{}, std::not_equal_to<uint8_t>{}))};
+
+        std::cout << "map " << row << "x" << col << ": " << built << " distance mismatches built, "
+                  << updated << " after updates, " << costs << " cost mismatches with a full update\n";
+        ok = ok && built == 0 && updated == 0 && costs == 0;
+    }
+    return ok;
+}
+
+static void bench(std::mt19937& rng, const Options& opts)
+{
+    const int n{opts.size};
+    const float side{n * BENCH_RESOLUTION};
+    MapGen gen{0.0f, side, 0.0f, side, n, n};
+    DenseMap& map{gen.map};
+    for (auto& status : map.grid_status) status = rng() % 1000 < 2;
+    for (int i = 0; i < 200; ++i) {
+        gen.add_obstacle((rng() % n) * BENCH_RESOLUTION, (rng() % n) * BENCH_RESOLUTION, 2.0f, 4.0f);
+    }
+
+    tp::ThreadPool pool{opts.threads};
+    Costmap cm{map, {.max_distance=2.0f, .inscribed_radius=1.0f, .inflation_radius=2.0f, .cost_scaling=3.0f}, &pool};
+    const auto full_start{std::chrono::steady_clock::now()};
+    cm.update();
+    const double full_ms{ms_since(full_start)};
+
+    double total_ms{0.0};
+    double max_ms{0.0};
+    for (int i = 0; i < BENCH_UPDATES; ++i) {
+        const int r0{static_cast<int>(rng() % (n - BENCH_UPDATE_CELLS))};
+        const int c0{static_cast<int>(rng() % (n - BENCH_UPDATE_CELLS))};
+        for (int r = r0; r < r0 + BENCH_UPDATE_CELLS; ++r) {
+            for (int c = c0; c < c0 + BENCH_UPDATE_CELLS; ++c) {
+                map.grid_status[r * n + c] ^= rng() % 7 == 0;
+            }
+        }
+        const auto start{std::chrono::steady_clock::now()};
+        cm.update(r0, r0 + BENCH_UPDATE_CELLS, c0, c0 + BENCH_UPDATE_CELLS);
+        const double ms{ms_since(start)};
+        total_ms += ms;
+        max_ms = std::max(max_ms, ms);
+    }
+
+    std::cout << n << "x" << n << " at " << BENCH_RESOLUTION << " m, " << opts.threads << " threads\n"
+              << "full update: " << full_ms << " ms\n"
+              << "incremental " << BENCH_UPDATE_CELLS << "x" << BENCH_UPDATE_CELLS << " update: "
+              << total_ms / BENCH_UPDATES << " ms avg, " << max_ms << " ms max\n";
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::cerr << "usage: " << argv[0] << " [--size CELLS] [--threads N] [--seed N]\n";
+        return 1;
+    }
+    std::mt19937 rng{opts.seed};
+    if (!check(rng)) {
+        std::cerr << "costmap check failed\n";
+        return 1;
+    }
+    bench(rng, opts);
+    return 0;
+}
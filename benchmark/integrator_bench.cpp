@@ -0,0 +1,95 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include "integrator.hpp"
+
+// Final position error against step count for the integrators in
+// integrator.hpp, over a constant curvature arc and a clothoid.
+
+#define PATH_LENGTH 20.0    // meter
+
+struct Pose
+{
+    float x;
+    float y;
+    float heading;
+}; // struct Pose
+
+struct Maneuver
+{
+    const char* name;
+    double k0;
+    double dk;
+}; // struct Maneuver
+
+// reference solution, Simpson's rule in double with a very small step
+static void reference(const Maneuver& m, double& x, double& y)
+{
+    constexpr int n{1 << 20};
+    const double h{PATH_LENGTH / n};
+    auto heading = [&m](double s) { return m.k0 * s + 0.5 * m.dk * s * s; };
+    x = 0.0;
+    y = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const double s{i * h};
+        const double h0{heading(s)};
+        const double h1{heading(s + 0.5 * h)};
+        const double h2{heading(s + h)};
+        x += h / 6.0 * (std::cos(h0) + 4.0 * std::cos(h1) + std::cos(h2));
+        y += h / 6.0 * (std::sin(h0) + 4.0 * std::sin(h1) + std::sin(h2));
+    }
+}
+
+static double error(const Pose& p, double ref_x, double ref_y)
+{
+    return std::hypot(p.x - ref_x, p.y - ref_y);
+}
+
+int main()
+{
+    const Maneuver maneuvers[]{
+        {.name="arc", .k0=0.2, .dk=0.0},
+        {.name="clothoid", .k0=0.0, .dk=0.02},
+    };
+
+    std::cout << std::scientific << std::setprecision(3);
+    for (const auto& m : maneuvers) {
+        double ref_x;
+        double ref_y;
+        reference(m, ref_x, ref_y);
+
+        std::cout << "== " << m.name << " ==\n"
+                  << std::setw(8) << "steps" << std::setw(12) << "euler"
+                  << std::setw(12) << "arc" << std::setw(12) << "rk4" << "\n";
+        for (int n = 1; n <= 256; n *= 2) {
+            const float ds{static_cast<float>(PATH_LENGTH / n)};
+            Pose euler{0.0f, 0.0f, 0.0f};
+            Pose arc{0.0f, 0.0f, 0.0f};
+            Pose rk4{0.0f, 0.0f, 0.0f};
+            for (int i = 0; i < n; ++i) {
+                const float s{i * ds};
+                const float k_start{static_cast<float>(m.k0 + m.dk * s)};
+                const float k_mid{static_cast<float>(m.k0 + m.dk * (s + 0.5f * ds))};
+                integ::euler(euler, k_start, ds);
+                integ::arc(arc, k_mid, ds);
+                integ::rk4(rk4, {.k0=k_start, .dk=static_cast<float>(m.dk)}, ds);
+            }
+            std::cout << std::setw(8) << n
+                      << std::setw(12) << error(euler, ref_x, ref_y)
+                      << std::setw(12) << error(arc, ref_x, ref_y)
+                      << std::setw(12) << error(rk4, ref_x, ref_y) << "\n";
+        }
+
+        std::cout << std::setw(8) << "tol" << std::setw(12) << "adaptive" << std::setw(12) << "steps" << "\n";
+        for (float tol = 1.0e-1f; tol > 1.0e-7f; tol *= 0.1f) {
+            Pose p{0.0f, 0.0f, 0.0f};
+            const int steps{integ::adaptive(p, {.k0=static_cast<float>(m.k0), .dk=static_cast<float>(m.dk)},
+                static_cast<float>(PATH_LENGTH), tol)};
+            std::cout << std::setw(8) << std::setprecision(0) << tol << std::setprecision(3)
+                      << std::setw(12) << error(p, ref_x, ref_y)
+                      << std::setw(12) << steps << "\n";
+        }
+    }
+    return 0;
+}
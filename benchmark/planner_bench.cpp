@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "arena.hpp"
+#include "hierarchical_planner.hpp"
+#include "hybrid_a_star.hpp"
+#include "instrument.hpp"
+#include "map_corpus.hpp"
+#include "rrt.hpp"
+#include "rspath.h"
+
+// HybridAStar, the hierarchical planner, RRT and the Reeds-Shepp solver over the seeded map corpus,
+// every (kind, size, seed) is planned once per planner. Prints JSON.
+
+#define WHEEL_BASE      2.8f    // meter
+#define RS_TURN_RADIUS  3.0f    // meter
+#define RRT_MAX_ITER    10000
+#define RRT_GOAL_DIST   2.0f    // meter
+#define COARSE_CELL     4.0f    // meter
+#define GUIDE_CELL      1.0f    // meter
+#define CORRIDOR_RADIUS 2       // coarse cells
+
+enum BenchPlanner {
+    BENCH_HYBRID_A_STAR = 0,
+    BENCH_HIERARCHICAL,
+    BENCH_RRT,
+    BENCH_RS,
+    NUM_BENCH_PLANNERS,
+}; // enum BenchPlanner
+
+static const char* bench_planner_names[NUM_BENCH_PLANNERS]{"hybrid_a_star", "hierarchical", "rrt", "reeds_shepp"};
+
+struct Options
+{
+    std::vector<float> sizes;   // meter
+    int seeds;                  // maps per (kind, size)
+    unsigned int seed;          // first seed
+    float resolution;           // meter per cell
+    size_t max_expansions;      // HybridAStar
+    int rs_calls;               // solver calls per map
+    const char* out;            // nullptr prints to stdout
+    const char* trace;          // Chrome trace output, needs PLANNER_INSTRUMENT
+}; // struct Options
+
+struct Run
+{
+    bool found;
+    size_t expansions;  // expanded states, tree nodes or solver calls
+    double wall_ms;
+    float path_cost;    // meter
+    size_t arena_peak;  // bytes
+}; // struct Run
+
+void usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [--sizes 50,100,200] [--seeds N] [--seed N] [--resolution METER]"
+              << " [--max-expansions N] [--rs-calls N] [--out FILE] [--trace FILE]\n";
+}
+
+bool parse_options(int argc, char** argv, Options& opts)
+{
+    opts = {
+        .sizes={50.0f, 100.0f, 200.0f},
+        .seeds=3,
+        .seed=0,
+        .resolution=0.5f,
+        .max_expansions=HAS_MAX_EXPANSIONS,
+        .rs_calls=10000,
+        .out=nullptr,
+        .trace=nullptr
+    };
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--sizes") == 0 && has_value) {
+            opts.sizes.clear();
+            for (char* s = argv[++i]; *s != '\0';) {
+                char* end;
+                const float size{std::strtof(s, &end)};
+                if (end == s || size <= 0.0f) return false;
+                opts.sizes.push_back(size);
+                s = *end == ',' ? end + 1 : end;
+            }
+        } else if (std::strcmp(argv[i], "--seeds") == 0 && has_value) {
+            opts.seeds = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            opts.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--resolution") == 0 && has_value) {
+            opts.resolution = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-expansions") == 0 && has_value) {
+            opts.max_expansions = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--rs-calls") == 0 && has_value) {
+            opts.rs_calls = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out") == 0 && has_value) {
+            opts.out = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && has_value) {
+            opts.trace = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return !opts.sizes.empty() && opts.resolution > 0.0f;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+}
+
+template<typename T>
+static float path_length(const std::vector<T>& path)
+{
+    float length{0.0f};
+    for (size_t i = 1; i < path.size(); ++i) {
+        length += euclidean_dist(path[i - 1], path[i]);
+    }
+    return length;
+}
+
+static Run run_hybrid_a_star(const CorpusMap& cm, const Options& opts, const integ::KinematicConfig& kin)
+{
+    Arena arena;
+    const State init{.x=cm.start.x, .y=cm.start.y, .heading=cm.start.heading};
+    const State goal{.x=cm.goal.x, .y=cm.goal.y, .heading=cm.goal.heading};
+    const auto start{std::chrono::steady_clock::now()};
+    HybridAStar has{init, goal, kin, &cm.map, &arena};
+    const bool found{has.search(opts.max_expansions)};
+    return {
+        .found=found,
+        .expansions=has.expansions(),
+        .wall_ms=ms_since(start),
+        .path_cost=has.path_cost(),
+        .arena_peak=arena.peak()
+    };
+}
+
+// coarse and fine expansions, the pyramid is built once per map and not timed
+static Run run_hierarchical(const CorpusMap& cm, const Options& opts, const integ::KinematicConfig& kin)
+{
+    Arena arena;
+    const State init{.x=cm.start.x, .y=cm.start.y, .heading=cm.start.heading};
+    const State goal{.x=cm.goal.x, .y=cm.goal.y, .heading=cm.goal.heading};
+    HierarchicalPlanner planner{cm.map, {
+        .coarse_cell=COARSE_CELL,
+        .guide_cell=GUIDE_CELL,
+        .corridor_radius=CORRIDOR_RADIUS,
+        .max_expansions=opts.max_expansions
+    }};
+    std::vector<State> path;
+    const auto start{std::chrono::steady_clock::now()};
+    const bool found{planner.plan(init, goal, kin, path, &arena)};
+    return {
+        .found=found,
+        .expansions=planner.coarse_expansions() + planner.fine_expansions(),
+        .wall_ms=ms_since(start),
+        .path_cost=planner.path_cost(),
+        .arena_peak=arena.peak()
+    };
+}
+
+static Run run_rrt(const CorpusMap& cm, const integ::KinematicConfig& kin)
+{
+    Arena arena;
+    const RRT::State init{.x=cm.start.x, .y=cm.start.y, .heading=cm.start.heading, .parent=-1};
+    const RRT::State goal{.x=cm.goal.x, .y=cm.goal.y, .heading=cm.goal.heading, .parent=-1};
+    const auto start{std::chrono::steady_clock::now()};
+    RRT rrt{goal, kin, &cm.map, &arena, cm.seed};
+    const bool found{rrt.search(init, RRT_MAX_ITER, RRT_GOAL_DIST)};
+    const double wall_ms{ms_since(start)};
+    std::vector<RRT::State> path;
+    return {
+        .found=found,
+        .expansions=rrt.graph().size(),
+        .wall_ms=wall_ms,
+        .path_cost=found && rrt.extract_path(path) ? path_length(path) : INFINITY,
+        .arena_peak=arena.peak()
+    };
+}
+
+// obstacle-free shortest Reeds-Shepp path from start to goal, solved rs_calls times
+static Run run_rs(const CorpusMap& cm, const Options& opts)
+{
+    const float dx{cm.goal.x - cm.start.x};
+    const float dy{cm.goal.y - cm.start.y};
+    const float cos_yaw{std::cos(cm.start.heading)};
+    const float sin_yaw{std::sin(cm.start.heading)};
+    const float x{(cos_yaw * dx + sin_yaw * dy) / RS_TURN_RADIUS};
+    const float y{(-sin_yaw * dx + cos_yaw * dy) / RS_TURN_RADIUS};
+    const float phi{cm.goal.heading - cm.start.heading};
+
+    RsPath rs_path;
+    float length{0.0f};
+    const auto start{std::chrono::steady_clock::now()};
+    INSTR_SCOPE("reeds_shepp.batch");
+    for (int i = 0; i < opts.rs_calls; ++i) {
+        rs_find_from_all_path(x, y, phi, &rs_path);
+        length += rs_path.length;
+    }
+    INSTR_ADD(instr::CNT_RS_CALLS, opts.rs_calls);
+    return {
+        .found=true,
+        .expansions=static_cast<size_t>(opts.rs_calls),
+        .wall_ms=ms_since(start),
+        .path_cost=length / opts.rs_calls * RS_TURN_RADIUS,
+        .arena_peak=0
+    };
+}
+
+// value below which a fraction p of the sorted samples fall
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    const size_t i{static_cast<size_t>(std::ceil(p * sorted.size()))};
+    return sorted[std::min(sorted.size() - 1, i > 0 ? i - 1 : 0)];
+}
+
+static void write_group(std::ostream& os, BenchPlanner planner, MapKind kind, float size, const std::vector<Run>& runs)
+{
+    std::vector<double> wall_ms;
+    size_t found{0};
+    size_t expansions{0};
+    size_t arena_peak{0};
+    double total_ms{0.0};
+    double cost{0.0};
+    for (const auto& r : runs) {
+        wall_ms.push_back(r.wall_ms);
+        expansions += r.expansions;
+        total_ms += r.wall_ms;
+        arena_peak = std::max(arena_peak, r.arena_peak);
+        if (r.found) {
+            ++found;
+            cost += r.path_cost;
+        }
+    }
+    std::sort(wall_ms.begin(), wall_ms.end());
+
+    const double n{static_cast<double>(runs.size())};
+    os << "    {\"planner\": \"" << bench_planner_names[planner] << "\""
+       << ", \"map\": \"" << stringify(kind) << "\""
+       << ", \"size\": " << size
+       << ", \"runs\": " << runs.size()
+       << ", \"found\": " << found
+       << ", \"expansions_mean\": " << expansions / n
+       << ", \"nodes_per_sec\": " << expansions * 1000.0 / std::max(total_ms, 1.0e-9)
+       << ", \"wall_ms\": {\"p50\": " << percentile(wall_ms, 0.5)
+       << ", \"p90\": " << percentile(wall_ms, 0.9)
+       << ", \"p99\": " << percentile(wall_ms, 0.99)
+       << ", \"max\": " << wall_ms.back() << "}"
+       << ", \"path_cost_mean\": ";
+    if (found > 0) {
+        os << cost / found;
+    } else {
+        os << "null";
+    }
+    os << ", \"arena_peak_bytes\": " << arena_peak << "}";
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ofstream file;
+    if (opts.out != nullptr) {
+        file.open(opts.out);
+        if (!file) {
+            std::cerr << "Open output " << opts.out << " failed\n";
+            return 1;
+        }
+    }
+    std::ostream& os{file.is_open() ? file : std::cout};
+
+    const integ::KinematicConfig kin{.wheel_base=WHEEL_BASE, .method=integ::INTEG_ARC, .tolerance=1.0e-3f};
+    std::vector<Run> runs[NUM_BENCH_PLANNERS];
+    bool first{true};
+
+    os << "{\n  \"seed\": " << opts.seed
+       << ", \"seeds\": " << opts.seeds
+       << ", \"resolution\": " << opts.resolution
+       << ",\n  \"results\": [\n";
+    for (int k = 0; k < NUM_MAP_KINDS; ++k) {
+        const auto kind{static_cast<MapKind>(k)};
+        for (float size : opts.sizes) {
+            for (auto& r : runs) r.clear();
+            for (int s = 0; s < opts.seeds; ++s) {
+                CorpusMap cm;
+                if (!make_corpus_map(kind, size, opts.resolution, opts.seed + s, cm)) {
+                    std::cerr << stringify(kind) << " " << size << " m seed " << opts.seed + s
+                              << ": no free start / goal, skipped\n";
+                    continue;
+                }
+                runs[BENCH_HYBRID_A_STAR].push_back(run_hybrid_a_star(cm, opts, kin));
+                runs[BENCH_HIERARCHICAL].push_back(run_hierarchical(cm, opts, kin));
+                runs[BENCH_RRT].push_back(run_rrt(cm, kin));
+                runs[BENCH_RS].push_back(run_rs(cm, opts));
+            }
+            for (int p = 0; p < NUM_BENCH_PLANNERS; ++p) {
+                if (runs[p].empty()) continue;
+                if (!first) os << ",\n";
+                first = false;
+                write_group(os, static_cast<BenchPlanner>(p), kind, size, runs[p]);
+            }
+            std::cerr << stringify(kind) << " " << size << " m done\n";
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    os << "\n  ],\n  \"peak_rss_kb\": " << usage.ru_maxrss;
+    if (instr::enabled) {
+        uint64_t counters[instr::NUM_COUNTERS];
+        instr::totals(counters);
+        os << ",\n  \"counters\": {";
+        for (int i = 0; i < instr::NUM_COUNTERS; ++i) {
+            os << (i > 0 ? ", " : "") << "\"" << instr::counter_name(static_cast<instr::Counter>(i)) << "\": "
+               << counters[i];
+        }
+        os << "}";
+    }
+    os << "\n}\n";
+
+    if (opts.trace != nullptr) {
+        if (!instr::enabled) {
+            std::cerr << "Instrumentation is compiled out, configure with -DPLANNER_INSTRUMENT=ON\n";
+        } else if (!instr::write_chrome_trace(opts.trace)) {
+            std::cerr << "Write trace " << opts.trace << " failed\n";
+        }
+    }
+    return 0;
+}
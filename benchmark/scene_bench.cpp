@@ -0,0 +1,40 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "scene.hpp"
+
+// Step and lead lookup cost of the behavior_planning scene at several sizes
+
+int main()
+{
+    constexpr int ticks{1000};
+
+    std::mt19937 rng{0};
+    std::uniform_int_distribution<int> lane_dist{0, NUM_LANES - 1};
+    for (int n : {100, 1000, 10000, 100000}) {
+        Scene scene;
+        scene.seed(n);
+        for (int i = 0; i < n; ++i) {
+            scene.add(i, lane_dist(rng), rand_ab(rng, -10.0f, 10.0f * n), rand_ab(rng, 10.0f, 40.0f), 0.0f);
+        }
+
+        const auto step_start{std::chrono::steady_clock::now()};
+        for (int t = 0; t < ticks; ++t) {
+            scene.step(STEP_SIZE, 0.0f);
+        }
+        const std::chrono::duration<double, std::micro> step_time{std::chrono::steady_clock::now() - step_start};
+
+        int found{0};
+        const auto query_start{std::chrono::steady_clock::now()};
+        for (int q = 0; q < ticks; ++q) {
+            found += scene.lead(q % NUM_LANES, static_cast<float>(q * 10)) >= 0;
+        }
+        const std::chrono::duration<double, std::nano> query_time{std::chrono::steady_clock::now() - query_start};
+
+        std::cout << "participants: " << n
+                  << ", step: " << step_time.count() / ticks << " us"
+                  << ", lead query: " << query_time.count() / ticks << " ns"
+                  << " (" << found << " found)\n";
+    }
+    return 0;
+}
@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
 #define BICYCLE_IMPLEMENTATION
 #include "bicycle.hpp"
 
@@ -8,6 +13,9 @@
 #define RVIZ_IMPLEMENTATION
 #include "rviz.hpp"
 
+#include "raster.hpp"
+#include "viz_sink.hpp"
+
 
 #define WHEEL_TRACE     1.9f    // meter
 #define WHEEL_WIDTH     0.3f    // meter
@@ -16,9 +24,92 @@
 #define MIN_STEER       -0.5f   // rad
 #define MAX_STEER       0.5f    // rad
 
-int main()
+struct Options
 {
-    auto viz{rviz::Viz::instance()};
+    const char* record;     // dump the trajectory to a viz trace instead of opening a window
+    const char* png;        // rasterize the trajectory to a PNG instead of opening a window
+    int png_size;           // pixel
+    int steps;              // simulated steps without a window
+    int vehicle_every;      // steps between vehicle outlines without a window
+}; // struct Options
+
+bool parse_options(int argc, char** argv, Options& opts)
+{
+    opts = {.record=nullptr, .png=nullptr, .png_size=1024, .steps=1000, .vehicle_every=50};
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--record") == 0 && has_value) {
+            opts.record = argv[++i];
+        } else if (std::strcmp(argv[i], "--png") == 0 && has_value) {
+            opts.png = argv[++i];
+        } else if (std::strcmp(argv[i], "--png-size") == 0 && has_value) {
+            opts.png_size = std::max(16, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--steps") == 0 && has_value) {
+            opts.steps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--vehicle-every") == 0 && has_value) {
+            opts.vehicle_every = std::max(1, std::atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void step(bicycle::Bicycle& model, int i)
+{
+    const float accel{i < 10 ? 0.1f : 0.0f};
+    const float steer_spd{i < 100 ? 0.1f :
+        model.state().steer_angle > 0.0f ? -0.01f : 0.01f
+    };
+    model.act(steer_spd, accel, 0.2f);
+}
+
+// fixed number of steps into a file sink or a PNG, no window
+int headless(bicycle::Bicycle& model, const Options& opts)
+{
+    viz::FileSink file;
+    raster::Rasterizer rast{WHEEL_BASE + 2.0f * WHEEL_RADIUS, WHEEL_TRACE + WHEEL_WIDTH};
+    viz::VizSink* sink{&rast};
+    if (opts.record != nullptr) {
+        if (!file.open(opts.record)) {
+            std::cerr << "Open trace " << opts.record << " failed\n";
+            return 1;
+        }
+        sink = &file;
+    }
+
+    for (int i = 0; i < opts.steps; ++i) {
+        step(model, i);
+        const auto& s{model.state()};
+        sink->point(viz::LAYER_PATH, s.x, s.y);
+        if (i % opts.vehicle_every == 0 || i + 1 == opts.steps) {
+            sink->vehicle(s.x, s.y, s.yaw, s.steer_angle);
+        }
+    }
+
+    if (opts.record != nullptr) {
+        std::cout << file.count() << " draw commands written to " << opts.record << "\n";
+        return 0;
+    }
+    raster::Canvas canvas{opts.png_size, opts.png_size};
+    rast.fit(canvas);
+    rast.render(canvas);
+    if (!canvas.write_png(opts.png)) {
+        std::cerr << "Write " << opts.png << " failed\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::cerr << "usage: " << argv[0] << " [--record FILE | --png FILE [--png-size PIXEL]]"
+                  << " [--steps N] [--vehicle-every N]\n";
+        return 1;
+    }
+
     bicycle::Bicycle::State state{0};
     bicycle::Bicycle::Config cfg{
         .wheel_base=WHEEL_BASE,
@@ -27,7 +118,11 @@ int main()
         .min_steer=MIN_STEER
     };
     bicycle::Bicycle model(state, cfg);
+    if (opts.record != nullptr || opts.png != nullptr) {
+        return headless(model, opts);
+    }
 
+    auto viz{rviz::Viz::instance()};
     rviz::VehState2d rviz_state;
     rviz_state.heading = 0.0f;
     rviz_state.steer_angle = 0;
@@ -40,12 +135,7 @@ int main()
 
     int i{0};
     while (!viz->closed()) {
-        const float accel{i < 10 ? 0.1f : 0.0f};
-        const float steer_spd{i < 100 ? 0.1f : 
-            model.state().steer_angle > 0.0f ? -0.01f : 0.01f
-        };
-
-        model.act(steer_spd, accel, 0.2f);
+        step(model, i);
         rviz_state.x = model.state().x;
         rviz_state.y = model.state().y;
         rviz_state.steer_angle = model.state().steer_angle;
@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "costmap.hpp"
+#include "map_gen.hpp"
+
+#define BICYCLE_IMPLEMENTATION
+#include "bicycle.hpp"
+
+#define HLOG_IMPLEMENTATION
+#include "hlog.h"
+
+#define THREAD_POOL_IMPLEMENTATION
+#include "thread_pool.hpp"
+
+#define RVIZ_TARGET_FPS 50
+#define RVIZ_IMPLEMENTATION
+#include "rviz.hpp"
+
+
+#define WHEEL_TRACE     1.9f    // meter
+#define WHEEL_WIDTH     0.3f    // meter
+#define WHEEL_RADIUS    0.4f    // meter
+#define WHEEL_BASE      2.8f    // meter
+#define MIN_STEER       -0.5f   // rad
+#define MAX_STEER       0.5f    // rad
+
+#define MPPI_SAMPLES    4096
+#define MPPI_HORIZON    50
+#define MPPI_DT         0.02f   // second, 50 Hz
+#define MPPI_CHUNK      64      // samples per task, each chunk draws from its own seed
+#define MPPI_SEED       1
+
+#define INSCRIBED_RADIUS    1.1f    // meter, half the vehicle width
+#define INFLATION_RADIUS    3.0f    // meter
+
+
+template<typename T>
+inline T pow2(T v) { return v * v; }
+
+// seed of the i-th sample chunk of a run, independent of which worker runs it
+inline unsigned int chunk_seed(uint64_t seed, uint64_t i)
+{
+    uint64_t z{seed + (i + 1) * 0x9e3779b97f4a7c15ull};
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<unsigned int>(z ^ (z >> 31));
+}
+
+struct Waypoint
+{
+    float x;
+    float y;
+}; // struct Waypoint
+
+struct Control
+{
+    float steer_spd;
+    float accel;
+}; // struct Control
+
+struct MppiConfig
+{
+    int num_samples;
+    int horizon;
+    float dt;               // second
+    float lambda;           // temperature of the path integral weights
+    float steer_spd_sigma;  // rad/s
+    float accel_sigma;      // m/s^2
+    float max_steer_spd;    // rad/s
+    float max_accel;        // m/s^2
+    float obstacle_weight;  // inside the inscribed radius of an obstacle
+    float inflation_weight; // at COST_INSCRIBED, scaled down with the inflation cost
+    float path_weight;
+    float progress_weight;
+    unsigned int seed;      // the same seed and inputs give the same controls
+}; // struct MppiConfig
+
+class Mppi
+{
+public:
+    Mppi(const MppiConfig& cfg, const bicycle::Bicycle::Config& veh_cfg, const Costmap& costmap,
+        const std::vector<Waypoint>& ref_path, tp::ThreadPool& pool);
+    ~Mppi() = default;
+    Control solve(const bicycle::Bicycle::State& state);
+private:
+    void rollouts(const bicycle::Bicycle::State& init, int begin, int end, int worker);
+    void update_nominal();
+    int nearest_ref(float x, float y, int start, int window) const;
+
+    struct Sampler
+    {
+        std::mt19937 rng;
+        std::normal_distribution<float> normal;
+    }; // struct Sampler
+
+    MppiConfig cfg_;
+    bicycle::Bicycle::Config veh_cfg_;
+    const Costmap& costmap_;
+    const std::vector<Waypoint>& ref_path_;
+    tp::ThreadPool& pool_;
+    int ref_idx_;
+    uint64_t num_solves_;
+
+    // all buffers are sized once here and reused by every solve
+    std::vector<Control> nominal_;      // horizon
+    std::vector<Control> noise_;        // num_samples x horizon, sample major
+    std::vector<float> costs_;          // num_samples
+    std::vector<Sampler> samplers_;     // one per worker, reseeded for every chunk
+}; // class Mppi
+
+Mppi::Mppi(const MppiConfig& cfg, const bicycle::Bicycle::Config& veh_cfg, const Costmap& costmap,
+    const std::vector<Waypoint>& ref_path, tp::ThreadPool& pool)
+    : cfg_(cfg)
+    , veh_cfg_(veh_cfg)
+    , costmap_(costmap)
+    , ref_path_(ref_path)
+    , pool_(pool)
+    , ref_idx_(0)
+    , num_solves_(0)
+{
+    nominal_.resize(cfg_.horizon, Control{.steer_spd=0.0f, .accel=0.0f});
+    noise_.resize(static_cast<size_t>(cfg_.num_samples) * cfg_.horizon);
+    costs_.resize(cfg_.num_samples);
+
+    samplers_.resize(pool_.size(), {.rng=std::mt19937{}, .normal=std::normal_distribution<float>{0.0f, 1.0f}});
+}
+
+Control Mppi::solve(const bicycle::Bicycle::State& state)
+{
+    ref_idx_ = nearest_ref(state.x, state.y, ref_idx_, 32);
+
+    pool_.parallel_for(cfg_.num_samples, MPPI_CHUNK, [this, &state](int begin, int end, int worker) {
+        rollouts(state, begin, end, worker);
+    });
+    update_nominal();
+    ++num_solves_;
+
+    // warm start the next cycle with the shifted sequence
+    const Control control{nominal_.front()};
+    std::rotate(nominal_.begin(), nominal_.begin() + 1, nominal_.end());
+    if (cfg_.horizon > 1) {
+        nominal_.back() = nominal_.at(cfg_.horizon - 2);
+    }
+    return control;
+}
+
+void Mppi::rollouts(const bicycle::Bicycle::State& init, int begin, int end, int worker)
+{
+    auto& sampler{samplers_.at(worker)};
+    const uint64_t num_chunks{static_cast<uint64_t>(cfg_.num_samples + MPPI_CHUNK - 1) / MPPI_CHUNK};
+    sampler.rng.seed(chunk_seed(cfg_.seed, num_solves_ * num_chunks + begin / MPPI_CHUNK));
+    sampler.normal.reset();
+    const float inv_var_steer{1.0f / pow2(cfg_.steer_spd_sigma)};
+    const float inv_var_accel{1.0f / pow2(cfg_.accel_sigma)};
+
+    for (int k = begin; k < end; ++k) {
+        bicycle::Bicycle veh{init, veh_cfg_};
+        Control* eps{noise_.data() + static_cast<size_t>(k) * cfg_.horizon};
+        int ref{ref_idx_};
+        float cost{0.0f};
+
+        for (int t = 0; t < cfg_.horizon; ++t) {
+            const auto& u_nom{nominal_[t]};
+            // sample 0 rolls out the nominal sequence itself
+            float steer_spd{u_nom.steer_spd};
+            float accel{u_nom.accel};
+            if (k > 0) {
+                steer_spd += cfg_.steer_spd_sigma * sampler.normal(sampler.rng);
+                accel += cfg_.accel_sigma * sampler.normal(sampler.rng);
+            }
+            steer_spd = std::clamp(steer_spd, -cfg_.max_steer_spd, cfg_.max_steer_spd);
+            accel = std::clamp(accel, -cfg_.max_accel, cfg_.max_accel);
+            eps[t].steer_spd = steer_spd - u_nom.steer_spd;
+            eps[t].accel = accel - u_nom.accel;
+
+            veh.act(steer_spd, accel, cfg_.dt);
+            const auto& s{veh.state()};
+
+            const uint8_t cell_cost{costmap_.cost(s.x, s.y)};
+            if (cell_cost >= COST_INSCRIBED) {
+                cost += cfg_.obstacle_weight;
+            } else {
+                cost += cfg_.inflation_weight / COST_INSCRIBED * cell_cost;
+            }
+            ref = nearest_ref(s.x, s.y, ref, 8);
+            cost += cfg_.path_weight * (pow2(s.x - ref_path_[ref].x) + pow2(s.y - ref_path_[ref].y));
+            cost += cfg_.lambda * (u_nom.steer_spd * eps[t].steer_spd * inv_var_steer +
+                u_nom.accel * eps[t].accel * inv_var_accel);
+        }
+
+        cost -= cfg_.progress_weight * (ref - ref_idx_);
+        costs_[k] = cost;
+    }
+}
+
+void Mppi::update_nominal()
+{
+    const float min_cost{*std::min_element(costs_.begin(), costs_.end())};
+    float weight_sum{0.0f};
+    for (auto& c : costs_) {
+        c = std::exp(-(c - min_cost) / cfg_.lambda);
+        weight_sum += c;
+    }
+
+    for (int k = 0; k < cfg_.num_samples; ++k) {
+        const float w{costs_[k] / weight_sum};
+        if (w < 1.0e-6f) continue;
+        const Control* eps{noise_.data() + static_cast<size_t>(k) * cfg_.horizon};
+        for (int t = 0; t < cfg_.horizon; ++t) {
+            nominal_[t].steer_spd += w * eps[t].steer_spd;
+            nominal_[t].accel += w * eps[t].accel;
+        }
+    }
+}
+
+int Mppi::nearest_ref(float x, float y, int start, int window) const
+{
+    const int end{std::min(static_cast<int>(ref_path_.size()), start + window)};
+    int result{start};
+    float min_dist{INFINITY};
+    for (int i = start; i < end; ++i) {
+        const float this_dist{pow2(ref_path_[i].x - x) + pow2(ref_path_[i].y - y)};
+        if (this_dist < min_dist) {
+            min_dist = this_dist;
+            result = i;
+        }
+    }
+    return result;
+}
+
+struct Options
+{
+    int samples;
+    int horizon;            // steps of MPPI_DT
+    int threads;            // 0 uses every core
+    int scaling;            // > 0 times that many solves per pool size from 1 to every core, no window
+}; // struct Options
+
+bool parse_options(int argc, char** argv, Options& opts)
+{
+    opts = {.samples=MPPI_SAMPLES, .horizon=MPPI_HORIZON, .threads=0, .scaling=0};
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--samples") == 0 && has_value) {
+            opts.samples = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--horizon") == 0 && has_value) {
+            opts.horizon = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            opts.threads = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--scaling") == 0 && has_value) {
+            opts.scaling = std::max(1, std::atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+MppiConfig mppi_config(const Options& opts)
+{
+    return {
+        .num_samples=opts.samples,
+        .horizon=opts.horizon,
+        .dt=MPPI_DT,
+        .lambda=1.0f,
+        .steer_spd_sigma=0.3f,
+        .accel_sigma=1.0f,
+        .max_steer_spd=0.6f,
+        .max_accel=3.0f,
+        .obstacle_weight=1000.0f,
+        .inflation_weight=10.0f,
+        .path_weight=1.0f,
+        .progress_weight=2.0f,
+        .seed=MPPI_SEED
+    };
+}
+
+// closed loop solve times for pool sizes 1, 2, 4 .. and every core
+int scaling(const Options& opts, const bicycle::Bicycle::Config& veh_cfg, const Costmap& costmap,
+    const std::vector<Waypoint>& ref_path)
+{
+    const int cores{static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))};
+    double single_ms{0.0};
+    for (int threads = 1; ; threads = std::min(2 * threads, cores)) {
+        tp::ThreadPool pool{threads};
+        Mppi mppi{mppi_config(opts), veh_cfg, costmap, ref_path, pool};
+        bicycle::Bicycle model{bicycle::Bicycle::State{0}, veh_cfg};
+        double total_ms{0.0};
+        double max_ms{0.0};
+        for (int i = 0; i < opts.scaling; ++i) {
+            const auto start{std::chrono::steady_clock::now()};
+            const Control control{mppi.solve(model.state())};
+            const std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+            total_ms += elapsed.count();
+            max_ms = std::max(max_ms, elapsed.count());
+            model.act(control.steer_spd, control.accel, MPPI_DT);
+        }
+        const double avg_ms{total_ms / opts.scaling};
+        if (threads == 1) single_ms = avg_ms;
+        std::cout << "mppi " << opts.samples << "x" << opts.horizon << ", " << threads << " threads"
+                  << " avg: " << avg_ms << " ms, max: " << max_ms << " ms, speedup: " << single_ms / avg_ms
+                  << " (budget " << MPPI_DT * 1000.0f << " ms)\n";
+        if (threads == cores) break;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::cerr << "usage: " << argv[0] << " [--samples N] [--horizon STEPS] [--threads N] [--scaling SOLVES]\n";
+        return 1;
+    }
+
+    MapGen map_gen{-10.0f, 190.0f, -20.0f, 20.0f, 2000, 400};
+    map_gen.add_obstacle(40.0f, 0.5f, 2.0f, 4.0f);
+    map_gen.add_obstacle(90.0f, -1.0f, 2.0f, 4.0f);
+    map_gen.add_obstacle(140.0f, 1.5f, 2.0f, 4.0f);
+
+    std::vector<Waypoint> ref_path;
+    for (float x = 0.0f; x < 180.0f; x += 0.5f) {
+        ref_path.push_back({.x=x, .y=2.0f * std::sin(x / 20.0f)});
+    }
+
+    const bicycle::Bicycle::Config veh_cfg{
+        .wheel_base=WHEEL_BASE,
+        .gc_to_back_axle=WHEEL_BASE/2,
+        .max_steer=MAX_STEER,
+        .min_steer=MIN_STEER
+    };
+    tp::ThreadPool pool{opts.threads};
+    const Costmap costmap{map_gen.map, {
+        .max_distance=INFLATION_RADIUS,
+        .inscribed_radius=INSCRIBED_RADIUS,
+        .inflation_radius=INFLATION_RADIUS,
+        .cost_scaling=2.0f
+    }, &pool};
+    if (opts.scaling > 0) {
+        return scaling(opts, veh_cfg, costmap, ref_path);
+    }
+    Mppi mppi{mppi_config(opts), veh_cfg, costmap, ref_path, pool};
+
+    bicycle::Bicycle::State state{0};
+    bicycle::Bicycle model(state, veh_cfg);
+
+    rviz::VehState2d rviz_state;
+    rviz_state.wheel_base = WHEEL_BASE;
+    rviz_state.wheel_track = WHEEL_TRACE;
+    rviz_state.wheel_radius = WHEEL_RADIUS;
+    rviz_state.wheel_width = WHEEL_WIDTH;
+
+    auto viz{rviz::Viz::instance()};
+    for (const auto& wp : ref_path) {
+        viz->draw_trj2d_point_("test/ref", wp.x, wp.y);
+    }
+
+    int cycle{0};
+    double total_ms{0.0};
+    double max_ms{0.0};
+    while (!viz->closed()) {
+        const auto start{std::chrono::steady_clock::now()};
+        const Control control{mppi.solve(model.state())};
+        const std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+        total_ms += elapsed.count();
+        max_ms = std::max(max_ms, elapsed.count());
+        if (++cycle % 50 == 0) {
+            std::cout << "mppi " << opts.samples << "x" << opts.horizon
+                      << " avg: " << total_ms / 50 << " ms, max: " << max_ms << " ms"
+                      << " (budget " << MPPI_DT * 1000.0f << " ms)\n";
+            total_ms = 0.0;
+            max_ms = 0.0;
+        }
+
+        model.act(control.steer_spd, control.accel, MPPI_DT);
+        rviz_state.x = model.state().x;
+        rviz_state.y = model.state().y;
+        rviz_state.steer_angle = model.state().steer_angle;
+        rviz_state.heading = model.state().yaw;
+        viz->draw_vehicle2d("test/veh", rviz_state);
+        viz->draw_trj2d_point_("test/trj", rviz_state.x, rviz_state.y);
+        viz->render();
+    }
+    return 0;
+}
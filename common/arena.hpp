@@ -0,0 +1,119 @@
+#ifndef COMMON_ARENA_H_
+#define COMMON_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Bump allocator: nothing is freed on its own, reset() releases everything
+// at once and keeps the blocks for the next round.
+class Arena
+{
+public:
+    explicit Arena(size_t block_size = 1 << 20)
+        : block_(0)
+        , offset_(0)
+        , used_(0)
+        , peak_(0)
+        , block_size_(block_size)
+    {}
+    ~Arena()
+    {
+        for (auto& b : blocks_) std::free(b.data);
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align)
+    {
+        assert(align > 0 && (align & (align - 1)) == 0);
+        while (block_ < blocks_.size()) {
+            auto& b{blocks_[block_]};
+            const size_t start{(offset_ + align - 1) & ~(align - 1)};
+            if (start + size <= b.size) {
+                offset_ = start + size;
+                used_ += size;
+                peak_ = used_ > peak_ ? used_ : peak_;
+                return b.data + start;
+            }
+            ++block_;
+            offset_ = 0;
+        }
+
+        // oversized requests get a block of their own
+        const size_t block_size{size + align > block_size_ ? size + align : block_size_};
+        char* data{static_cast<char*>(std::malloc(block_size))};
+        if (data == nullptr) throw std::bad_alloc{};
+        blocks_.push_back({.data=data, .size=block_size});
+        block_ = blocks_.size() - 1;
+        offset_ = 0;
+        return allocate(size, align);
+    }
+
+    inline void reset()
+    {
+        block_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    // bytes handed out since the last reset
+    inline size_t used() const { return used_; }
+    // most bytes handed out between two resets
+    inline size_t peak() const { return peak_; }
+    inline size_t capacity() const
+    {
+        size_t n{0};
+        for (const auto& b : blocks_) n += b.size;
+        return n;
+    }
+private:
+    struct Block
+    {
+        char* data;
+        size_t size;
+    }; // struct Block
+
+    std::vector<Block> blocks_;
+    size_t block_;
+    size_t offset_;
+    size_t used_;
+    size_t peak_;
+    size_t block_size_;
+}; // class Arena
+
+// STL allocator drawing from an arena, or from the heap without one
+template<typename T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator(Arena* arena_ = nullptr) : arena(arena_) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n)
+    {
+        if (arena != nullptr) {
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        if (arena == nullptr) ::operator delete(p);
+    }
+
+    Arena* arena;
+}; // struct ArenaAllocator
+
+template<typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+
+template<typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
+
+#endif // COMMON_ARENA_H_
@@ -0,0 +1,205 @@
+#ifndef COMMON_INSTRUMENT_H_
+#define COMMON_INSTRUMENT_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Planner instrumentation: event counters and scoped timers kept in
+// per-thread buffers, exported as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev). Everything is compiled out unless PLANNER_INSTRUMENT
+// is defined, see the PLANNER_INSTRUMENT cmake option.
+//
+//   INSTR_SCOPE("hybrid_a_star.search");   // timer until the end of the scope
+//   INSTR_COUNT(instr::CNT_EXPANSIONS);
+//
+// Counters and events are only written by their own thread, read them with
+// totals() / write_chrome_trace() once the planners are idle.
+
+#define INSTR_MAX_EVENTS (1 << 20)   // per thread, later scopes are dropped
+
+namespace instr {
+
+enum Counter {
+    CNT_EXPANSIONS = 0,
+    CNT_QUEUE_PUSHES,
+    CNT_QUEUE_POPS,
+    CNT_RS_CALLS,
+    CNT_COLLISION_CHECKS,
+    CNT_NN_QUERIES,
+    NUM_COUNTERS,
+}; // enum Counter
+
+inline const char* counter_name(Counter c)
+{
+    static const char* names[NUM_COUNTERS]{
+        "expansions", "queue_pushes", "queue_pops", "rs_calls", "collision_checks", "nn_queries"
+    };
+    return c < NUM_COUNTERS ? names[c] : "unknown";
+}
+
+#ifdef PLANNER_INSTRUMENT
+constexpr bool enabled{true};
+#else
+constexpr bool enabled{false};
+#endif
+
+struct Event
+{
+    const char* name;   // string literal
+    int64_t begin;      // ns since the trace epoch
+    int64_t duration;   // ns
+}; // struct Event
+
+struct ThreadBuffer
+{
+    int tid;
+    uint64_t counters[NUM_COUNTERS];
+    std::vector<Event> events;
+    size_t dropped;
+}; // struct ThreadBuffer
+
+// buffers outlive their threads so worker traces survive the pool
+struct Registry
+{
+    std::mutex mtx;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::chrono::steady_clock::time_point epoch{std::chrono::steady_clock::now()};
+}; // struct Registry
+
+inline Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+inline thread_local ThreadBuffer* tls_buffer{nullptr};
+
+inline ThreadBuffer* register_thread()
+{
+    auto& r{registry()};
+    std::lock_guard<std::mutex> lock{r.mtx};
+    r.buffers.push_back(std::make_unique<ThreadBuffer>());
+    auto* b{r.buffers.back().get()};
+    b->tid = static_cast<int>(r.buffers.size()) - 1;
+    for (auto& c : b->counters) c = 0;
+    b->events.reserve(1024);
+    b->dropped = 0;
+    return b;
+}
+
+inline ThreadBuffer& local()
+{
+    if (__builtin_expect(tls_buffer == nullptr, 0)) tls_buffer = register_thread();
+    return *tls_buffer;
+}
+
+inline int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - registry().epoch).count();
+}
+
+inline void count(Counter c, uint64_t n = 1)
+{
+    local().counters[c] += n;
+}
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char* name)
+        : name_(name)
+        , begin_(now_ns())
+    {}
+    ~ScopedTimer()
+    {
+        auto& b{local()};
+        if (b.events.size() < INSTR_MAX_EVENTS) {
+            b.events.push_back({.name=name_, .begin=begin_, .duration=now_ns() - begin_});
+        } else {
+            ++b.dropped;
+        }
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+private:
+    const char* name_;
+    int64_t begin_;
+}; // class ScopedTimer
+
+// sum over every thread seen so far
+inline void totals(uint64_t out[NUM_COUNTERS])
+{
+    auto& r{registry()};
+    std::lock_guard<std::mutex> lock{r.mtx};
+    for (int i = 0; i < NUM_COUNTERS; ++i) out[i] = 0;
+    for (const auto& b : r.buffers) {
+        for (int i = 0; i < NUM_COUNTERS; ++i) out[i] += b->counters[i];
+    }
+}
+
+inline void reset()
+{
+    auto& r{registry()};
+    std::lock_guard<std::mutex> lock{r.mtx};
+    for (auto& b : r.buffers) {
+        for (auto& c : b->counters) c = 0;
+        b->events.clear();
+        b->dropped = 0;
+    }
+}
+
+// one complete ("X") event per timed scope, the counter totals of every
+// thread as a counter ("C") event after its last scope
+inline bool write_chrome_trace(const char* path)
+{
+    std::ofstream os{path};
+    if (!os) return false;
+
+    auto& r{registry()};
+    std::lock_guard<std::mutex> lock{r.mtx};
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    os << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"planner\"}}";
+    for (const auto& b : r.buffers) {
+        os << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << b->tid
+           << ", \"args\": {\"name\": \"thread " << b->tid << "\"}}";
+        int64_t last{0};
+        for (const auto& e : b->events) {
+            os << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << b->tid
+               << ", \"ts\": " << e.begin / 1000.0 << ", \"dur\": " << e.duration / 1000.0 << "}";
+            last = std::max(last, e.begin + e.duration);
+        }
+        os << ",\n{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 0, \"tid\": " << b->tid
+           << ", \"ts\": " << last / 1000.0 << ", \"args\": {";
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+            os << (i > 0 ? ", " : "") << "\"" << counter_name(static_cast<Counter>(i)) << "\": " << b->counters[i];
+        }
+        os << ", \"dropped_scopes\": " << b->dropped << "}}";
+    }
+    os << "\n]}\n";
+    return static_cast<bool>(os);
+}
+
+} // namespace instr
+
+#define INSTR_CONCAT_(a, b) a##b
+#define INSTR_CONCAT(a, b) INSTR_CONCAT_(a, b)
+
+#ifdef PLANNER_INSTRUMENT
+#define INSTR_SCOPE(name) instr::ScopedTimer INSTR_CONCAT(instr_scope_, __LINE__){name}
+#define INSTR_COUNT(c) instr::count(c)
+#define INSTR_ADD(c, n) instr::count(c, n)
+#else
+#define INSTR_SCOPE(name) ((void)0)
+#define INSTR_COUNT(c) ((void)0)
+#define INSTR_ADD(c, n) ((void)0)
+#endif
+
+#endif // COMMON_INSTRUMENT_H_
@@ -0,0 +1,142 @@
+#ifndef COMMON_INTEGRATOR_H_
+#define COMMON_INTEGRATOR_H_
+
+#include <algorithm>
+#include <cmath>
+
+// Kinematic integrators shared by the planners and simulators.
+//
+// Lateral motion is parameterized by arc length: for a pose (x, y, heading)
+//     dx/ds = cos(heading), dy/ds = sin(heading), dheading/ds = k(s)
+// with the curvature k(s) = k0 + dk * s held over one step. Any type with
+// float members x, y and heading can be integrated.
+
+namespace integ {
+
+enum Method {
+    INTEG_EULER = 0,    // heading first, then position (the old planner update)
+    INTEG_ARC,          // exact for constant curvature
+    INTEG_RK4,
+    INTEG_ADAPTIVE,     // RK4 with step doubling
+}; // enum Method
+
+struct KinematicConfig
+{
+    float wheel_base;   // meter
+    Method method;
+    float tolerance;    // meter, position error per step for INTEG_ADAPTIVE
+}; // struct KinematicConfig
+
+struct Curvature
+{
+    float k0;           // 1/meter
+    float dk;           // 1/meter^2
+}; // struct Curvature
+
+inline float steer_curvature(float steer_angle, float wheel_base)
+{
+    return std::tan(steer_angle) / wheel_base;
+}
+
+template<typename S>
+inline void euler(S& s, float k, float ds)
+{
+    s.heading += k * ds;
+    s.x += ds * std::cos(s.heading);
+    s.y += ds * std::sin(s.heading);
+}
+
+template<typename S>
+inline void arc(S& s, float k, float ds)
+{
+    // move along the chord of the arc, it has the mean heading of the arc
+    const float half{0.5f * k * ds};
+    const float chord{std::abs(half) < 1.0e-4f ? ds * (1.0f - half * half / 6.0f) : ds * std::sin(half) / half};
+    const float mid_heading{s.heading + half};
+    s.x += chord * std::cos(mid_heading);
+    s.y += chord * std::sin(mid_heading);
+    s.heading += 2.0f * half;
+}
+
+template<typename S>
+inline void rk4(S& s, const Curvature& k, float ds)
+{
+    const float h0{s.heading};
+    const float h_mid{h0 + ds * (0.5f * k.k0 + 0.125f * k.dk * ds)};
+    const float h_end{h0 + ds * (k.k0 + 0.5f * k.dk * ds)};
+    // the heading is a polynomial in s, so the two midpoint stages coincide
+    const float c_mid{std::cos(h_mid)};
+    const float s_mid{std::sin(h_mid)};
+    s.x += ds / 6.0f * (std::cos(h0) + 4.0f * c_mid + std::cos(h_end));
+    s.y += ds / 6.0f * (std::sin(h0) + 4.0f * s_mid + std::sin(h_end));
+    s.heading = h_end;
+}
+
+// Integrate over ds with as few RK4 sub steps as the tolerance allows,
+// returns the number of accepted sub steps.
+template<typename S>
+inline int adaptive(S& s, const Curvature& k, float ds, float tolerance)
+{
+    constexpr int max_steps{1024};
+
+    float done{0.0f};
+    float h{ds};
+    int steps{0};
+    while (std::abs(done) < std::abs(ds) && steps < max_steps) {
+        if (std::abs(done + h) > std::abs(ds)) h = ds - done;
+        const Curvature kh{.k0=k.k0 + k.dk * done, .dk=k.dk};
+
+        S full{s};
+        rk4(full, kh, h);
+        S half{s};
+        rk4(half, kh, 0.5f * h);
+        const Curvature kh2{.k0=kh.k0 + kh.dk * 0.5f * h, .dk=k.dk};
+        rk4(half, kh2, 0.5f * h);
+
+        const float err{std::max(std::abs(full.x - half.x), std::abs(full.y - half.y))};
+        if (err <= tolerance || std::abs(h) < 1.0e-3f) {
+            s.x = half.x;
+            s.y = half.y;
+            s.heading = half.heading;
+            done += h;
+            ++steps;
+            if (err < 0.1f * tolerance) h *= 2.0f;
+        } else {
+            h *= 0.5f;
+        }
+    }
+    return steps;
+}
+
+// Move a pose by the arc length ds with a constant steer angle
+template<typename S>
+inline void step(S& s, const KinematicConfig& cfg, float steer_angle, float ds)
+{
+    const float k{steer_curvature(steer_angle, cfg.wheel_base)};
+    switch (cfg.method) {
+    case INTEG_EULER:
+        euler(s, k, ds);
+        break;
+    case INTEG_RK4:
+        rk4(s, {.k0=k, .dk=0.0f}, ds);
+        break;
+    case INTEG_ADAPTIVE:
+        adaptive(s, {.k0=k, .dk=0.0f}, ds, cfg.tolerance);
+        break;
+    case INTEG_ARC:
+    default:
+        arc(s, k, ds);
+        break;
+    }
+}
+
+// Longitudinal motion under a constant acceleration, exact over dt
+inline void longitudinal(float& position, float& vel, float accel, float dt)
+{
+    position += vel * dt + 0.5f * accel * dt * dt;
+    vel += accel * dt;
+}
+
+} // namespace integ
+
+#endif // COMMON_INTEGRATOR_H_
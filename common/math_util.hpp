@@ -0,0 +1,19 @@
+#ifndef COMMON_MATH_UTIL_H_
+#define COMMON_MATH_UTIL_H_
+
+#include <cmath>
+
+template<typename T>
+inline T pow2(T v) { return v * v; }
+
+template<typename T>
+inline T pow3(T v) { return v * v * v; }
+
+// planar distance between anything with x and y members
+template<typename A, typename B>
+inline float euclidean_dist(const A& a, const B& b)
+{
+    return std::sqrt(pow2(a.x - b.x) + pow2(a.y - b.y));
+}
+
+#endif // COMMON_MATH_UTIL_H_
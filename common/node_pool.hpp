@@ -0,0 +1,175 @@
+#ifndef COMMON_NODE_POOL_H_
+#define COMMON_NODE_POOL_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "arena.hpp"
+
+// Append-only node storage addressed by 32 bit indices. Nodes live in fixed
+// size chunks that never move, so references stay valid while the pool grows,
+// and clear() drops every node at once while keeping the chunks.
+template<typename T, int CHUNK_BITS = 12>
+class NodePool
+{
+    static_assert(std::is_trivially_destructible<T>::value, "nodes are dropped without destruction");
+public:
+    static constexpr uint32_t CHUNK_SIZE{1u << CHUNK_BITS};
+
+    // chunks are taken from the arena when one is given, they are then
+    // released by the arena reset instead of the pool
+    explicit NodePool(Arena* arena = nullptr)
+        : arena_(arena)
+        , chunks_(ArenaAllocator<T*>{arena})
+        , size_(0)
+    {}
+    ~NodePool()
+    {
+        if (arena_ != nullptr) return;
+        for (T* c : chunks_) std::free(c);
+    }
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    inline uint32_t push(const T& v)
+    {
+        const uint32_t idx{size_};
+        if ((idx >> CHUNK_BITS) == chunks_.size()) {
+            grow();
+        }
+        chunks_[idx >> CHUNK_BITS][idx & (CHUNK_SIZE - 1)] = v;
+        ++size_;
+        return idx;
+    }
+
+    inline T& operator[](uint32_t i)
+    {
+        assert(i < size_);
+        return chunks_[i >> CHUNK_BITS][i & (CHUNK_SIZE - 1)];
+    }
+    inline const T& operator[](uint32_t i) const
+    {
+        assert(i < size_);
+        return chunks_[i >> CHUNK_BITS][i & (CHUNK_SIZE - 1)];
+    }
+    inline T& back() { return (*this)[size_ - 1]; }
+
+    inline uint32_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+    inline void clear() { size_ = 0; }
+
+    // contiguous run of nodes of the i-th chunk, for scans over the whole pool
+    inline const T* chunk(size_t i) const { return chunks_[i]; }
+    inline uint32_t chunk_size(size_t i) const
+    {
+        const uint32_t begin{static_cast<uint32_t>(i) << CHUNK_BITS};
+        return size_ - begin < CHUNK_SIZE ? size_ - begin : CHUNK_SIZE;
+    }
+    inline size_t num_chunks() const { return (size_ + CHUNK_SIZE - 1) >> CHUNK_BITS; }
+    inline size_t bytes() const { return chunks_.size() * CHUNK_SIZE * sizeof(T); }
+private:
+    void grow()
+    {
+        const size_t bytes{CHUNK_SIZE * sizeof(T)};
+        void* p{arena_ != nullptr ? arena_->allocate(bytes, alignof(T)) : std::malloc(bytes)};
+        if (p == nullptr) throw std::bad_alloc{};
+        chunks_.push_back(static_cast<T*>(p));
+    }
+
+    Arena* arena_;
+    std::vector<T*, ArenaAllocator<T*>> chunks_;
+    uint32_t size_;
+}; // class NodePool
+
+// Open-list entry, the node itself stays in its pool
+struct OpenEntry
+{
+    float cost;
+    uint32_t node;
+
+    bool operator<(const OpenEntry& other) const { return cost < other.cost; }
+}; // struct OpenEntry
+
+static_assert(sizeof(OpenEntry) == 8, "open-list entries are meant to be 8 bytes");
+
+// Linear probing set of 64 bit keys in one flat table, for closed sets.
+// EMPTY_KEY cannot be stored.
+class FlatKeySet
+{
+public:
+    static constexpr uint64_t EMPTY_KEY{~0ull};
+
+    explicit FlatKeySet(Arena* arena = nullptr, size_t capacity = 1024)
+        : slots_(ArenaAllocator<uint64_t>{arena})
+        , size_(0)
+    {
+        size_t n{16};
+        while (n < capacity) n <<= 1;
+        slots_.assign(n, EMPTY_KEY);
+    }
+
+    // false if the key was already there
+    inline bool insert(uint64_t key)
+    {
+        assert(key != EMPTY_KEY);
+        // keep the load under 1/2 so probes stay short
+        if (2 * (size_ + 1) > slots_.size()) {
+            rehash(2 * slots_.size());
+        }
+        const size_t mask{slots_.size() - 1};
+        for (size_t i = mix(key) & mask;; i = (i + 1) & mask) {
+            if (slots_[i] == key) return false;
+            if (slots_[i] == EMPTY_KEY) {
+                slots_[i] = key;
+                ++size_;
+                return true;
+            }
+        }
+    }
+
+    inline bool contains(uint64_t key) const
+    {
+        const size_t mask{slots_.size() - 1};
+        for (size_t i = mix(key) & mask;; i = (i + 1) & mask) {
+            if (slots_[i] == key) return true;
+            if (slots_[i] == EMPTY_KEY) return false;
+        }
+    }
+
+    inline size_t size() const { return size_; }
+    inline void clear()
+    {
+        std::fill(slots_.begin(), slots_.end(), EMPTY_KEY);
+        size_ = 0;
+    }
+private:
+    static inline uint64_t mix(uint64_t k)
+    {
+        k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ull;
+        k = (k ^ (k >> 27)) * 0x94d049bb133111ebull;
+        return k ^ (k >> 31);
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<uint64_t, ArenaAllocator<uint64_t>> old{capacity, EMPTY_KEY, slots_.get_allocator()};
+        old.swap(slots_);
+        const size_t mask{slots_.size() - 1};
+        for (const uint64_t key : old) {
+            if (key == EMPTY_KEY) continue;
+            size_t i{mix(key) & mask};
+            while (slots_[i] != EMPTY_KEY) i = (i + 1) & mask;
+            slots_[i] = key;
+        }
+    }
+
+    std::vector<uint64_t, ArenaAllocator<uint64_t>> slots_;
+    size_t size_;
+}; // class FlatKeySet
+
+#endif // COMMON_NODE_POOL_H_
@@ -0,0 +1,485 @@
+#ifndef COMMON_RASTER_H_
+#define COMMON_RASTER_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "viz_sink.hpp"
+
+// Headless drawing for machines without a display: viz sink commands and
+// occupancy grids are rasterized on the CPU into an indexed framebuffer
+// and written as PNG.
+//
+//   raster::Rasterizer rast;                // collects what the planner draws
+//   planner.set_viz(&rast);
+//   ...
+//   raster::Canvas canvas{1024, 1024};
+//   rast.fit(canvas);
+//   rast.render(canvas);
+//   canvas.write_png("out.png");
+
+namespace raster {
+
+enum Color : uint8_t {
+    COLOR_BACKGROUND = 0,
+    COLOR_OCCUPIED,
+    COLOR_EXPANSION,
+    COLOR_TREE,
+    COLOR_PATH,
+    COLOR_VEHICLE,
+    NUM_COLORS,
+}; // enum Color
+
+inline const uint8_t* palette_rgb()
+{
+    static const uint8_t rgb[NUM_COLORS * 3]{
+        255, 255, 255,  // background
+        64, 64, 64,     // occupied
+        120, 170, 230,  // expansion
+        90, 180, 90,    // tree
+        220, 40, 40,    // path
+        20, 20, 20,     // vehicle
+    };
+    return rgb;
+}
+
+// color of a viz layer
+inline Color layer_color(viz::Layer layer)
+{
+    switch (layer) {
+    case viz::LAYER_EXPANSION: return COLOR_EXPANSION;
+    case viz::LAYER_TREE: return COLOR_TREE;
+    case viz::LAYER_PATH: return COLOR_PATH;
+    case viz::LAYER_VEHICLE: return COLOR_VEHICLE;
+    case viz::NUM_LAYERS: break;
+    }
+    return COLOR_VEHICLE;
+}
+
+// PNG with a palette, compressed with fixed Huffman deflate. Runs and
+// repeats of the row above are the only matches looked for, which is most
+// of what a plot has.
+namespace png {
+
+inline uint32_t crc32(const uint8_t* data, size_t n, uint32_t crc = 0)
+{
+    static const std::array<uint32_t, 256> table{[]() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c{i};
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }()};
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline uint32_t adler32(const uint8_t* data, size_t n)
+{
+    uint32_t a{1};
+    uint32_t b{0};
+    for (size_t i = 0; i < n; ++i) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>& out)
+        : out_(out)
+        , acc_(0)
+        , bits_(0)
+    {}
+
+    // least significant bit first
+    inline void put(uint32_t value, int count)
+    {
+        acc_ |= value << bits_;
+        bits_ += count;
+        while (bits_ >= 8) {
+            out_.push_back(static_cast<uint8_t>(acc_));
+            acc_ >>= 8;
+            bits_ -= 8;
+        }
+    }
+
+    // Huffman codes go most significant bit first
+    inline void put_code(uint32_t code, int len)
+    {
+        uint32_t rev{0};
+        for (int i = 0; i < len; ++i) rev |= ((code >> i) & 1) << (len - 1 - i);
+        put(rev, len);
+    }
+
+    inline void flush()
+    {
+        if (bits_ > 0) out_.push_back(static_cast<uint8_t>(acc_));
+        acc_ = 0;
+        bits_ = 0;
+    }
+private:
+    std::vector<uint8_t>& out_;
+    uint32_t acc_;
+    int bits_;
+}; // class BitWriter
+
+inline void put_literal(BitWriter& bw, int sym)
+{
+    if (sym < 144) {
+        bw.put_code(0x30 + sym, 8);
+    } else if (sym < 256) {
+        bw.put_code(0x190 + sym - 144, 9);
+    } else if (sym < 280) {
+        bw.put_code(sym - 256, 7);
+    } else {
+        bw.put_code(0xc0 + sym - 280, 8);
+    }
+}
+
+inline void put_match(BitWriter& bw, int len, int dist)
+{
+    static const int len_base[29]{
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    static const int len_extra[29]{
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    static const int dist_base[30]{
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+        1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    static const int dist_extra[30]{
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    int l{28};
+    while (len_base[l] > len) --l;
+    put_literal(bw, 257 + l);
+    bw.put(len - len_base[l], len_extra[l]);
+
+    int d{29};
+    while (dist_base[d] > dist) --d;
+    bw.put_code(d, 5);
+    bw.put(dist - dist_base[d], dist_extra[d]);
+}
+
+// zlib stream of one fixed Huffman block
+inline void deflate(const std::vector<uint8_t>& raw, size_t stride, std::vector<uint8_t>& out)
+{
+    constexpr size_t max_len{258};
+    constexpr size_t max_dist{32768};
+
+    out.push_back(0x78);
+    out.push_back(0x01);
+    BitWriter bw{out};
+    bw.put(1, 1);   // final block
+    bw.put(1, 2);   // fixed Huffman
+    const size_t n{raw.size()};
+    size_t i{0};
+    while (i < n) {
+        size_t best_len{0};
+        size_t best_dist{0};
+        for (size_t dist : {size_t{1}, stride}) {
+            if (dist > i || dist > max_dist) continue;
+            size_t len{0};
+            while (len < max_len && i + len < n && raw[i + len] == raw[i + len - dist]) ++len;
+            if (len > best_len) {
+                best_len = len;
+                best_dist = dist;
+            }
+        }
+        if (best_len >= 3) {
+            put_match(bw, static_cast<int>(best_len), static_cast<int>(best_dist));
+            i += best_len;
+        } else {
+            put_literal(bw, raw[i]);
+            ++i;
+        }
+    }
+    put_literal(bw, 256);
+    bw.flush();
+
+    const uint32_t adler{adler32(raw.data(), raw.size())};
+    for (int s = 24; s >= 0; s -= 8) out.push_back(static_cast<uint8_t>(adler >> s));
+}
+
+inline void put_u32(std::vector<uint8_t>& out, uint32_t v)
+{
+    for (int s = 24; s >= 0; s -= 8) out.push_back(static_cast<uint8_t>(v >> s));
+}
+
+inline void put_chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+{
+    put_u32(out, static_cast<uint32_t>(data.size()));
+    const size_t start{out.size()};
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_u32(out, crc32(out.data() + start, out.size() - start));
+}
+
+// 8 bit indexed image, `pixels` holds width * height palette indices row by row
+inline bool write(const char* path, int width, int height, const uint8_t* pixels, const uint8_t* rgb, int num_colors)
+{
+    std::vector<uint8_t> raw;
+    raw.reserve(static_cast<size_t>(width + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);   // no filter
+        raw.insert(raw.end(), pixels + static_cast<size_t>(y) * width, pixels + static_cast<size_t>(y + 1) * width);
+    }
+
+    std::vector<uint8_t> file{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> chunk;
+    put_u32(chunk, width);
+    put_u32(chunk, height);
+    chunk.insert(chunk.end(), {8, 3, 0, 0, 0});   // 8 bit, palette, deflate, no filter, no interlace
+    put_chunk(file, "IHDR", chunk);
+    chunk.assign(rgb, rgb + num_colors * 3);
+    put_chunk(file, "PLTE", chunk);
+    chunk.clear();
+    deflate(raw, width + 1, chunk);
+    put_chunk(file, "IDAT", chunk);
+    chunk.clear();
+    put_chunk(file, "IEND", chunk);
+
+    std::FILE* fp{std::fopen(path, "wb")};
+    if (fp == nullptr) return false;
+    const bool ok{std::fwrite(file.data(), 1, file.size(), fp) == file.size()};
+    return std::fclose(fp) == 0 && ok;
+}
+
+} // namespace png
+
+class Canvas
+{
+public:
+    Canvas(int width, int height)
+        : width_(std::max(1, width))
+        , height_(std::max(1, height))
+        , pixels_(static_cast<size_t>(width_) * height_, COLOR_BACKGROUND)
+        , center_x_(0.0f)
+        , center_y_(0.0f)
+        , scale_(1.0f)
+    {}
+
+    // world window to show, the scale is the same along both axes and y points up
+    void set_view(float x0, float y0, float x1, float y1)
+    {
+        center_x_ = (x0 + x1) / 2.0f;
+        center_y_ = (y0 + y1) / 2.0f;
+        const float w{std::max(x1 - x0, 1.0e-3f)};
+        const float h{std::max(y1 - y0, 1.0e-3f)};
+        scale_ = std::min(width_ / w, height_ / h);
+    }
+
+    inline void to_pixel(float x, float y, int& px, int& py) const
+    {
+        px = static_cast<int>(std::floor((x - center_x_) * scale_ + width_ / 2.0f));
+        py = static_cast<int>(std::floor(height_ / 2.0f - (y - center_y_) * scale_));
+    }
+
+    inline void plot(int px, int py, Color c)
+    {
+        if (px < 0 || py < 0 || px >= width_ || py >= height_) return;
+        pixels_[static_cast<size_t>(py) * width_ + px] = c;
+    }
+
+    void dot(float x, float y, int radius, Color c)
+    {
+        int px;
+        int py;
+        to_pixel(x, y, px, py);
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) plot(px + dx, py + dy, c);
+        }
+    }
+
+    // Bresenham between the pixels of both ends
+    void line(float x0, float y0, float x1, float y1, Color c)
+    {
+        int px0;
+        int py0;
+        int px1;
+        int py1;
+        to_pixel(x0, y0, px0, py0);
+        to_pixel(x1, y1, px1, py1);
+        if ((px0 < 0 && px1 < 0) || (py0 < 0 && py1 < 0) ||
+            (px0 >= width_ && px1 >= width_) || (py0 >= height_ && py1 >= height_)) {
+            return;
+        }
+        const int dx{std::abs(px1 - px0)};
+        const int dy{-std::abs(py1 - py0)};
+        const int sx{px0 < px1 ? 1 : -1};
+        const int sy{py0 < py1 ? 1 : -1};
+        int err{dx + dy};
+        while (true) {
+            plot(px0, py0, c);
+            if (px0 == px1 && py0 == py1) break;
+            const int e2{2 * err};
+            if (e2 >= dy) {
+                err += dy;
+                px0 += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                py0 += sy;
+            }
+        }
+    }
+
+    // axis aligned world rectangle, at least one pixel
+    void fill_rect(float x0, float y0, float x1, float y1, Color c)
+    {
+        int px0;
+        int py0;
+        int px1;
+        int py1;
+        to_pixel(x0, y1, px0, py0);
+        to_pixel(x1, y0, px1, py1);
+        px0 = std::max(px0, 0);
+        py0 = std::max(py0, 0);
+        px1 = std::min(std::max(px1, px0 + 1), width_);
+        py1 = std::min(std::max(py1, py0 + 1), height_);
+        for (int py = py0; py < py1; ++py) {
+            std::fill(pixels_.begin() + static_cast<size_t>(py) * width_ + px0,
+                pixels_.begin() + static_cast<size_t>(py) * width_ + px1, c);
+        }
+    }
+
+    inline bool write_png(const char* path) const
+    {
+        return png::write(path, width_, height_, pixels_.data(), palette_rgb(), NUM_COLORS);
+    }
+
+    inline void clear() { std::fill(pixels_.begin(), pixels_.end(), COLOR_BACKGROUND); }
+    inline int width() const { return width_; }
+    inline int height() const { return height_; }
+    inline const uint8_t* pixels() const { return pixels_.data(); }
+private:
+    int width_;
+    int height_;
+    std::vector<uint8_t> pixels_;
+    float center_x_;
+    float center_y_;
+    float scale_;           // pixel per meter
+}; // class Canvas
+
+// Occupied cells of a grid laid out like DenseMap in a_star/map_gen.hpp:
+// row r covers the x cell row - 1 - r, column c the y cell col - 1 - c.
+template<typename Map>
+void draw_occupancy(Canvas& canvas, const Map& map)
+{
+    const float x_res{(map.x_range[1] - map.x_range[0]) / map.row};
+    const float y_res{(map.y_range[1] - map.y_range[0]) / map.col};
+    for (int r = 0; r < map.row; ++r) {
+        const float x{map.x_range[0] + (map.row - 1 - r) * x_res};
+        for (int c = 0; c < map.col; ++c) {
+            if (map.grid_status[static_cast<size_t>(r) * map.col + c] <= 0) continue;
+            const float y{map.y_range[0] + (map.col - 1 - c) * y_res};
+            canvas.fill_rect(x, y, x + x_res, y + y_res, COLOR_OCCUPIED);
+        }
+    }
+}
+
+// Sink keeping every command for a later render, so a search draws into
+// a plain vector and the rasterization runs once, layer by layer.
+class Rasterizer final : public viz::VizSink
+{
+public:
+    explicit Rasterizer(float vehicle_length = 4.5f, float vehicle_width = 1.9f)
+        : vehicle_length_(vehicle_length)
+        , vehicle_width_(vehicle_width)
+    {}
+
+    void draw(const viz::DrawCmd& cmd) override { batch_.push_back(cmd); }
+
+    // world box around everything drawn, false if nothing was
+    bool bounds(float& x0, float& y0, float& x1, float& y1) const
+    {
+        if (batch_.empty()) return false;
+        x0 = y0 = 1.0e9f;
+        x1 = y1 = -1.0e9f;
+        const float r{std::max(vehicle_length_, vehicle_width_)};
+        for (const auto& cmd : batch_) {
+            const bool veh{cmd.kind == viz::DRAW_VEHICLE};
+            x0 = std::min(x0, veh ? cmd.x0 - r : std::min(cmd.x0, cmd.x1));
+            y0 = std::min(y0, veh ? cmd.y0 - r : std::min(cmd.y0, cmd.y1));
+            x1 = std::max(x1, veh ? cmd.x0 + r : std::max(cmd.x0, cmd.x1));
+            y1 = std::max(y1, veh ? cmd.y0 + r : std::max(cmd.y0, cmd.y1));
+        }
+        return true;
+    }
+
+    // view the canvas on everything drawn with a 5% margin
+    void fit(Canvas& canvas) const
+    {
+        float x0;
+        float y0;
+        float x1;
+        float y1;
+        if (!bounds(x0, y0, x1, y1)) return;
+        const float margin{0.05f * std::max(x1 - x0, y1 - y0) + 1.0f};
+        canvas.set_view(x0 - margin, y0 - margin, x1 + margin, y1 + margin);
+    }
+
+    void render(Canvas& canvas) const
+    {
+        for (int layer = 0; layer < viz::NUM_LAYERS; ++layer) {
+            const Color c{layer_color(static_cast<viz::Layer>(layer))};
+            for (const auto& cmd : batch_) {
+                if (cmd.layer != layer) continue;
+                if (cmd.kind == viz::DRAW_POINT) {
+                    canvas.dot(cmd.x0, cmd.y0, layer == viz::LAYER_PATH ? 1 : 0, c);
+                } else if (cmd.kind == viz::DRAW_SEGMENT) {
+                    canvas.line(cmd.x0, cmd.y0, cmd.x1, cmd.y1, c);
+                } else {
+                    draw_vehicle(canvas, cmd, c);
+                }
+            }
+        }
+    }
+
+    inline void clear() { batch_.clear(); }
+    inline size_t size() const { return batch_.size(); }
+private:
+    // body outline centered on the position and a heading tick
+    void draw_vehicle(Canvas& canvas, const viz::DrawCmd& cmd, Color c) const
+    {
+        const float cos_h{std::cos(cmd.x1)};
+        const float sin_h{std::sin(cmd.x1)};
+        const float hl{vehicle_length_ / 2.0f};
+        const float hw{vehicle_width_ / 2.0f};
+        const float lx[4]{hl, -hl, -hl, hl};
+        const float ly[4]{hw, hw, -hw, -hw};
+        float xs[4];
+        float ys[4];
+        for (int i = 0; i < 4; ++i) {
+            xs[i] = cmd.x0 + cos_h * lx[i] - sin_h * ly[i];
+            ys[i] = cmd.y0 + sin_h * lx[i] + cos_h * ly[i];
+        }
+        for (int i = 0; i < 4; ++i) {
+            canvas.line(xs[i], ys[i], xs[(i + 1) % 4], ys[(i + 1) % 4], c);
+        }
+        const float steer{cmd.x1 + cmd.y1};
+        canvas.line(cmd.x0, cmd.y0, cmd.x0 + cos_h * hl, cmd.y0 + sin_h * hl, c);
+        canvas.line(cmd.x0 + cos_h * hl, cmd.y0 + sin_h * hl,
+            cmd.x0 + cos_h * hl + std::cos(steer) * hw, cmd.y0 + sin_h * hl + std::sin(steer) * hw, c);
+    }
+
+    std::vector<viz::DrawCmd> batch_;
+    float vehicle_length_;  // meter
+    float vehicle_width_;   // meter
+}; // class Rasterizer
+
+} // namespace raster
+
+#endif // COMMON_RASTER_H_
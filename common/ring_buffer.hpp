@@ -0,0 +1,52 @@
+#ifndef COMMON_RING_BUFFER_H_
+#define COMMON_RING_BUFFER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Fixed capacity buffer keeping the latest pushed items, never allocates after construction.
+// A zero capacity buffer only counts the pushes.
+template<typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(size_t capacity)
+        : data_(capacity)
+        , head_(0)
+        , total_(0)
+    {}
+    ~RingBuffer() = default;
+
+    inline void push(const T& v)
+    {
+        if (data_.empty()) {
+            ++total_;
+            return;
+        }
+        data_[head_] = v;
+        head_ = head_ + 1 == data_.size() ? 0 : head_ + 1;
+        ++total_;
+    }
+
+    // i-th kept item, oldest first
+    inline const T& at(size_t i) const
+    {
+        assert(i < size());
+        const size_t oldest{total_ < data_.size() ? 0 : head_};
+        const size_t idx{oldest + i};
+        return data_[idx < data_.size() ? idx : idx - data_.size()];
+    }
+
+    inline size_t size() const { return total_ < data_.size() ? total_ : data_.size(); }
+    inline size_t capacity() const { return data_.size(); }
+    // number of items pushed since construction, including overwritten ones
+    inline size_t total() const { return total_; }
+    inline void clear() { head_ = 0; total_ = 0; }
+private:
+    std::vector<T> data_;
+    size_t head_;
+    size_t total_;
+}; // class RingBuffer
+
+#endif // COMMON_RING_BUFFER_H_
@@ -0,0 +1,72 @@
+#ifndef COMMON_SPSC_QUEUE_H_
+#define COMMON_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Lock-free bounded queue for exactly one producer and one consumer thread,
+// never allocates after construction. The capacity is rounded up to a power of two.
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+        : data_(round_up(capacity))
+        , mask_(data_.size() - 1)
+        , head_(0)
+        , tail_(0)
+    {
+        assert(capacity > 0);
+    }
+    ~SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // producer, false if fewer than keep_free + 1 slots are free
+    inline bool try_push(const T& v, size_t keep_free = 0)
+    {
+        const size_t tail{tail_.load(std::memory_order_relaxed)};
+        if (tail - head_cache_ + keep_free >= data_.size()) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ + keep_free >= data_.size()) return false;
+        }
+        data_[tail & mask_] = v;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer, false if the queue is empty
+    inline bool try_pop(T& v)
+    {
+        const size_t head{head_.load(std::memory_order_relaxed)};
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return false;
+        }
+        v = data_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    inline size_t capacity() const { return data_.size(); }
+private:
+    static size_t round_up(size_t n)
+    {
+        size_t p{1};
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    std::vector<T> data_;
+    const size_t mask_;
+    // consumer side
+    alignas(64) std::atomic<size_t> head_;
+    size_t tail_cache_{0};
+    // producer side
+    alignas(64) std::atomic<size_t> tail_;
+    size_t head_cache_{0};
+}; // class SpscQueue
+
+#endif // COMMON_SPSC_QUEUE_H_
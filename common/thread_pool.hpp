@@ -0,0 +1,192 @@
+#ifndef COMMON_THREAD_POOL_H_
+#define COMMON_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tp {
+
+// Work-stealing pool: every worker owns a task deque, runs its own tasks
+// newest first and steals the oldest tasks of the others when it runs dry.
+class ThreadPool
+{
+public:
+    // the argument of a task is the id of the worker running it, in [0, size())
+    using Task = std::function<void(int)>;
+    using RangeFn = std::function<void(int begin, int end, int worker)>;
+
+    explicit ThreadPool(int num_workers = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+    void wait();
+    // split [0, n) into chunks of `grain` items and block until all of them are done
+    void parallel_for(int n, int grain, const RangeFn& fn);
+
+    inline int size() const { return static_cast<int>(workers_.size()); }
+private:
+    struct TaskQueue
+    {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    }; // struct TaskQueue
+
+    void worker_loop(int id);
+    bool pop(int id, Task& task);
+    bool steal(int id, Task& task);
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::atomic<unsigned int> next_queue_;
+    std::atomic<int> queued_;
+    std::atomic<int> pending_;
+    std::mutex mtx_;
+    std::condition_variable task_cv_;
+    std::condition_variable done_cv_;
+    bool stop_;
+}; // class ThreadPool
+
+} // namespace tp
+
+#endif // COMMON_THREAD_POOL_H_
+
+#ifdef THREAD_POOL_IMPLEMENTATION
+#ifndef THREAD_POOL_IMPLEMENTATION_DONE_
+#define THREAD_POOL_IMPLEMENTATION_DONE_
+
+#include <algorithm>
+
+namespace tp {
+
+ThreadPool::ThreadPool(int num_workers)
+    : next_queue_(0)
+    , queued_(0)
+    , pending_(0)
+    , stop_(false)
+{
+    if (num_workers <= 0) {
+        num_workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    queues_.reserve(num_workers);
+    for (int i = 0; i < num_workers; ++i) {
+        queues_.push_back(std::make_unique<TaskQueue>());
+    }
+    workers_.reserve(num_workers);
+    for (int i = 0; i < num_workers; ++i) {
+        workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mtx_};
+        stop_ = true;
+    }
+    task_cv_.notify_all();
+    for (auto& w : workers_) {
+        w.join();
+    }
+}
+
+void ThreadPool::submit(Task task)
+{
+    pending_.fetch_add(1);
+    auto& q{*queues_[next_queue_.fetch_add(1) % queues_.size()]};
+    {
+        std::lock_guard<std::mutex> lock{q.mtx};
+        q.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock{mtx_};
+        queued_.fetch_add(1);
+    }
+    task_cv_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock{mtx_};
+    done_cv_.wait(lock, [this]() { return pending_.load() == 0; });
+}
+
+void ThreadPool::parallel_for(int n, int grain, const RangeFn& fn)
+{
+    if (n <= 0) return;
+    grain = std::max(1, grain);
+    const int num_chunks{(n + grain - 1) / grain};
+
+    int remain{num_chunks};
+    std::mutex done_mtx;
+    std::condition_variable done_cv;
+    for (int begin = 0; begin < n; begin += grain) {
+        const int end{std::min(n, begin + grain)};
+        submit([&, begin, end](int worker) {
+            fn(begin, end, worker);
+            std::lock_guard<std::mutex> lock{done_mtx};
+            if (--remain == 0) {
+                done_cv.notify_one();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock{done_mtx};
+    done_cv.wait(lock, [&remain]() { return remain == 0; });
+}
+
+bool ThreadPool::pop(int id, Task& task)
+{
+    auto& q{*queues_[id]};
+    std::lock_guard<std::mutex> lock{q.mtx};
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int id, Task& task)
+{
+    const int n{size()};
+    for (int i = 1; i < n; ++i) {
+        auto& q{*queues_[(id + i) % n]};
+        std::lock_guard<std::mutex> lock{q.mtx};
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(int id)
+{
+    while (true) {
+        Task task;
+        if (pop(id, task) || steal(id, task)) {
+            queued_.fetch_sub(1);
+            task(id);
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock{mtx_};
+                done_cv_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{mtx_};
+        task_cv_.wait(lock, [this]() { return stop_ || queued_.load() > 0; });
+        if (stop_ && queued_.load() <= 0) return;
+    }
+}
+
+} // namespace tp
+
+#endif // THREAD_POOL_IMPLEMENTATION_DONE_
+#endif // THREAD_POOL_IMPLEMENTATION
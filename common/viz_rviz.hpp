@@ -0,0 +1,31 @@
+#ifndef COMMON_VIZ_RVIZ_H_
+#define COMMON_VIZ_RVIZ_H_
+
+#include "rviz.hpp"
+#include "viz_sink.hpp"
+
+namespace viz {
+
+// replays one sink command on rviz, call from the thread owning the window.
+// Vehicles take their wheel geometry from `shape`, they are skipped without one.
+inline void draw_rviz(rviz::Viz* v, const DrawCmd& cmd, const rviz::VehState2d* shape = nullptr)
+{
+    static const char* layer_names[NUM_LAYERS]{"trace/expansion", "trace/tree", "trace/path", "trace/vehicle"};
+    const char* name{cmd.layer < NUM_LAYERS ? layer_names[cmd.layer] : "trace/unknown"};
+    if (cmd.kind == DRAW_POINT) {
+        v->draw_trj2d_point_(name, cmd.x0, cmd.y0);
+    } else if (cmd.kind == DRAW_SEGMENT) {
+        v->draw_line_segment_(name, {.x=cmd.x0, .y=cmd.y0}, {.x=cmd.x1, .y=cmd.y1});
+    } else if (shape != nullptr) {
+        rviz::VehState2d veh{*shape};
+        veh.x = cmd.x0;
+        veh.y = cmd.y0;
+        veh.heading = cmd.x1;
+        veh.steer_angle = cmd.y1;
+        v->draw_vehicle2d(name, veh);
+    }
+}
+
+} // namespace viz
+
+#endif // COMMON_VIZ_RVIZ_H_
@@ -0,0 +1,220 @@
+#ifndef COMMON_VIZ_SINK_H_
+#define COMMON_VIZ_SINK_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "spsc_queue.hpp"
+
+// Where planners send what they want drawn, through VIZ_DRAW. Planners skip
+// every call when no sink is set, and without PLANNER_VIZ the calls are not
+// compiled at all.
+//
+//   NullSink    swallows everything
+//   QueueSink   lock-free queue drained by the render thread, drops instead of blocking,
+//               except for the path
+//   FileSink    binary dump for offline viewing, read back with read_viz_file()
+
+#define VIZ_FILE_MAGIC      0x315a4956u  // "VIZ1"
+#define VIZ_FILE_BATCH      4096         // commands buffered before a write
+#define VIZ_PATH_RESERVE    8            // 1/8 of a QueueSink is kept for the path
+
+namespace viz {
+
+#ifdef PLANNER_VIZ
+constexpr bool enabled{true};
+#else
+constexpr bool enabled{false};
+#endif
+
+enum DrawKind : uint8_t {
+    DRAW_POINT = 0,
+    DRAW_SEGMENT,
+    DRAW_VEHICLE,           // x0, y0 position, x1 heading, y1 steer angle
+}; // enum DrawKind
+
+enum Layer : uint8_t {
+    LAYER_EXPANSION = 0,    // states popped by a search
+    LAYER_TREE,             // sampling tree edges
+    LAYER_PATH,
+    LAYER_VEHICLE,
+    NUM_LAYERS,
+}; // enum Layer
+
+struct DrawCmd
+{
+    DrawKind kind;
+    Layer layer;
+    float x0;
+    float y0;
+    float x1;               // segment end, unused by points
+    float y1;
+}; // struct DrawCmd
+
+static_assert(sizeof(DrawCmd) == 20, "DrawCmd is written to files as is");
+
+class VizSink
+{
+public:
+    virtual ~VizSink() = default;
+    virtual void draw(const DrawCmd& cmd) = 0;
+
+    inline void point(Layer layer, float x, float y)
+    {
+        draw({.kind=DRAW_POINT, .layer=layer, .x0=x, .y0=y, .x1=x, .y1=y});
+    }
+    inline void segment(Layer layer, float x0, float y0, float x1, float y1)
+    {
+        draw({.kind=DRAW_SEGMENT, .layer=layer, .x0=x0, .y0=y0, .x1=x1, .y1=y1});
+    }
+    inline void vehicle(float x, float y, float heading, float steer)
+    {
+        draw({.kind=DRAW_VEHICLE, .layer=LAYER_VEHICLE, .x0=x, .y0=y, .x1=heading, .y1=steer});
+    }
+}; // class VizSink
+
+class NullSink final : public VizSink
+{
+public:
+    void draw(const DrawCmd&) override {}
+}; // class NullSink
+
+// draw() runs on the planning thread, drain() and close() on the render
+// thread. Only every `decimation`-th command of a layer is queued and a
+// queue short of `capacity / VIZ_PATH_RESERVE` free slots drops, except for
+// LAYER_PATH: all of it is queued, into the reserved slots and, once those
+// are taken, by waiting for the render thread until it closes the sink.
+class QueueSink final : public VizSink
+{
+public:
+    explicit QueueSink(size_t capacity = 1 << 16, int decimation = 1)
+        : queue_(capacity)
+        , reserve_(queue_.capacity() / VIZ_PATH_RESERVE)
+        , decimation_(decimation > 1 ? decimation : 1)
+        , seen_{}
+        , dropped_(0)
+        , closed_(false)
+    {}
+
+    void draw(const DrawCmd& cmd) override
+    {
+        if (cmd.layer == LAYER_PATH) {
+            while (!queue_.try_push(cmd)) {
+                if (closed_.load(std::memory_order_acquire)) return;
+                std::this_thread::yield();
+            }
+            return;
+        }
+        if (seen_[cmd.layer]++ % decimation_ != 0) return;
+        if (!queue_.try_push(cmd, reserve_)) {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    // no more drain() calls, draw() stops waiting for room
+    inline void close() { closed_.store(true, std::memory_order_release); }
+
+    // hands at most `max` queued commands to fn, returns how many
+    template<typename Fn>
+    size_t drain(Fn&& fn, size_t max = SIZE_MAX)
+    {
+        DrawCmd cmd;
+        size_t n{0};
+        while (n < max && queue_.try_pop(cmd)) {
+            fn(cmd);
+            ++n;
+        }
+        return n;
+    }
+
+    inline size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+private:
+    SpscQueue<DrawCmd> queue_;
+    const size_t reserve_;  // slots only LAYER_PATH may take
+    const uint32_t decimation_;
+    uint32_t seen_[NUM_LAYERS];
+    std::atomic<size_t> dropped_;
+    std::atomic<bool> closed_;
+}; // class QueueSink
+
+class FileSink final : public VizSink
+{
+public:
+    FileSink()
+        : fp_(nullptr)
+        , count_(0)
+    {
+        buffer_.reserve(VIZ_FILE_BATCH);
+    }
+    ~FileSink() { close(); }
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    bool open(const char* path)
+    {
+        close();
+        fp_ = std::fopen(path, "wb");
+        if (fp_ == nullptr) return false;
+        const uint32_t magic{VIZ_FILE_MAGIC};
+        return std::fwrite(&magic, sizeof(magic), 1, fp_) == 1;
+    }
+
+    void draw(const DrawCmd& cmd) override
+    {
+        if (fp_ == nullptr) return;
+        buffer_.push_back(cmd);
+        ++count_;
+        if (buffer_.size() == VIZ_FILE_BATCH) flush();
+    }
+
+    void close()
+    {
+        if (fp_ == nullptr) return;
+        flush();
+        std::fclose(fp_);
+        fp_ = nullptr;
+    }
+
+    inline size_t count() const { return count_; }
+private:
+    void flush()
+    {
+        if (!buffer_.empty()) std::fwrite(buffer_.data(), sizeof(DrawCmd), buffer_.size(), fp_);
+        buffer_.clear();
+    }
+
+    std::FILE* fp_;
+    std::vector<DrawCmd> buffer_;
+    size_t count_;
+}; // class FileSink
+
+// commands written by a FileSink, false if the file is missing or not a trace
+inline bool read_viz_file(const char* path, std::vector<DrawCmd>& cmds)
+{
+    std::FILE* fp{std::fopen(path, "rb")};
+    if (fp == nullptr) return false;
+    uint32_t magic{0};
+    bool ok{std::fread(&magic, sizeof(magic), 1, fp) == 1 && magic == VIZ_FILE_MAGIC};
+    DrawCmd cmd;
+    cmds.clear();
+    while (ok && std::fread(&cmd, sizeof(cmd), 1, fp) == 1) {
+        ok = cmd.kind <= DRAW_VEHICLE && cmd.layer < NUM_LAYERS;
+        if (ok) cmds.push_back(cmd);
+    }
+    std::fclose(fp);
+    return ok;
+}
+
+} // namespace viz
+
+// sink->call unless sink is nullptr, e.g. VIZ_DRAW(viz_, point(viz::LAYER_PATH, x, y))
+#ifdef PLANNER_VIZ
+#define VIZ_DRAW(sink, call) do { if ((sink) != nullptr) (sink)->call; } while (0)
+#else
+#define VIZ_DRAW(sink, call) ((void)0)
+#endif
+
+#endif // COMMON_VIZ_SINK_H_
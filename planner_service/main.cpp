@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "instrument.hpp"
+#include "map_corpus.hpp"
+#include "map_gen.hpp"
+#include "planner_service.hpp"
+
+#define WHEEL_BASE      2.8f    // meter
+#define POSE_CLEARANCE  2.0f    // meter, of generated poses from obstacles and the map border
+
+struct Options
+{
+    const char* requests;   // request file, "-" reads stdin
+    long gen;               // > 0 prints that many random requests and exits
+    int maps;               // seeded cluttered corpus maps, ids [0, maps)
+    float map_size;         // meter
+    int cells;              // per side
+    int threads;            // 0 uses every core
+    unsigned int seed;
+    bool print;             // one line per result
+    const char* trace;      // Chrome trace output, needs PLANNER_INSTRUMENT
+}; // struct Options
+
+void usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [--requests FILE] [--maps N] [--map-size METER] [--cells N]"
+              << " [--threads N] [--seed N] [--print] [--trace FILE]\n"
+              << "       " << prog << " --gen N [--maps N] [--map-size METER] [--cells N] [--seed N]\n"
+              << "request lines: <hybrid_a_star|rrt> <map id> <init x> <init y> <init heading>"
+              << " <goal x> <goal y> <goal heading>\n";
+}
+
+bool parse_options(int argc, char** argv, Options& opts)
+{
+    opts = {
+        .requests="-",
+        .gen=0,
+        .maps=4,
+        .map_size=100.0f,
+        .cells=200,
+        .threads=0,
+        .seed=0,
+        .print=false,
+        .trace=nullptr
+    };
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value{i + 1 < argc};
+        if (std::strcmp(argv[i], "--requests") == 0 && has_value) {
+            opts.requests = argv[++i];
+        } else if (std::strcmp(argv[i], "--gen") == 0 && has_value) {
+            opts.gen = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "--maps") == 0 && has_value) {
+            opts.maps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--map-size") == 0 && has_value) {
+            opts.map_size = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cells") == 0 && has_value) {
+            opts.cells = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            opts.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            opts.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--print") == 0) {
+            opts.print = true;
+        } else if (std::strcmp(argv[i], "--trace") == 0 && has_value) {
+            opts.trace = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return opts.map_size > 0.0f;
+}
+
+int gen_requests(const Options& opts, const std::vector<std::shared_ptr<const DenseMap>>& maps)
+{
+    std::mt19937 rng{opts.seed};
+    std::uniform_int_distribution<int> map_dist{0, opts.maps - 1};
+    long skipped{0};
+    for (long i = 0; i < opts.gen; ++i) {
+        const auto planner{static_cast<PlannerType>(i % NUM_PLANNERS)};
+        const int map_id{map_dist(rng)};
+        Pose init;
+        Pose goal;
+        if (!random_free_pose(*maps[map_id], rng, POSE_CLEARANCE, init) ||
+            !random_free_pose(*maps[map_id], rng, POSE_CLEARANCE, goal)) {
+            ++skipped;
+            continue;
+        }
+        std::cout << stringify(planner) << " " << map_id << " "
+                  << init.x << " " << init.y << " " << init.heading << " "
+                  << goal.x << " " << goal.y << " " << goal.heading << "\n";
+    }
+    if (skipped > 0) {
+        std::cerr << skipped << " requests skipped, no free pose found\n";
+    }
+    return skipped < opts.gen ? 0 : 1;
+}
+
+bool parse_request(const std::string& line, long id, PlanRequest& req)
+{
+    std::istringstream is{line};
+    std::string planner;
+    req.id = id;
+    is >> planner >> req.map_id >> req.init.x >> req.init.y >> req.init.heading
+       >> req.goal.x >> req.goal.y >> req.goal.heading;
+    return !is.fail() && parse_planner(planner, req.planner);
+}
+
+// value below which a fraction p of the sorted samples fall
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    const size_t i{static_cast<size_t>(std::ceil(p * sorted.size()))};
+    return sorted[std::min(sorted.size() - 1, i > 0 ? i - 1 : 0)];
+}
+
+// requests with an error are counted apart and left out of the planner stats
+void report(const std::vector<PlanResult>& results, int workers, double wall, size_t arena_peak)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const auto unknown_map{std::count_if(results.begin(), results.end(),
+        [](const PlanResult& r) { return r.error == PLAN_UNKNOWN_MAP; })};
+    std::cout << "== PLANNER SERVICE ==\n"
+              << " workers: " << workers << "\n"
+              << " requests: " << results.size() << "\n"
+              << " unknown map: " << unknown_map << "\n"
+              << " wall: " << wall << " s, " << results.size() / std::max(wall, 1.0e-9) << " qps\n"
+              << " arena peak: " << arena_peak << " bytes\n"
+              << " peak rss: " << usage.ru_maxrss << " KB\n";
+
+    for (int p = 0; p < NUM_PLANNERS; ++p) {
+        std::vector<double> plan_ms;
+        std::vector<double> latency_ms;
+        size_t found{0};
+        size_t expansions{0};
+        double busy_ms{0.0};
+        for (const auto& r : results) {
+            if (r.planner != p || r.error != PLAN_OK) continue;
+            plan_ms.push_back(r.plan_ms);
+            latency_ms.push_back(r.wait_ms + r.plan_ms);
+            found += r.found;
+            expansions += r.expansions;
+            busy_ms += r.plan_ms;
+        }
+        if (plan_ms.empty()) continue;
+        std::sort(plan_ms.begin(), plan_ms.end());
+        std::sort(latency_ms.begin(), latency_ms.end());
+
+        const double n{static_cast<double>(plan_ms.size())};
+        std::cout << "== " << stringify(static_cast<PlannerType>(p)) << " ==\n"
+                  << " requests: " << plan_ms.size() << ", found: " << found / n << "\n"
+                  << " expansions: " << expansions / n << " avg\n"
+                  << " plan: " << percentile(plan_ms, 0.5) << " ms p50, "
+                  << percentile(plan_ms, 0.99) << " ms p99, " << plan_ms.back() << " ms max\n"
+                  << " latency: " << percentile(latency_ms, 0.5) << " ms p50, "
+                  << percentile(latency_ms, 0.99) << " ms p99 (queueing included)\n"
+                  // what the pool would sustain if only this planner was requested
+                  << " qps: " << n * workers * 1000.0 / std::max(busy_ms, 1.0e-9) << "\n";
+    }
+}
+
+void write_trace(const char* path)
+{
+    if (!instr::enabled) {
+        std::cerr << "Instrumentation is compiled out, configure with -DPLANNER_INSTRUMENT=ON\n";
+        return;
+    }
+    uint64_t counters[instr::NUM_COUNTERS];
+    instr::totals(counters);
+    std::cout << "== COUNTERS ==\n";
+    for (int i = 0; i < instr::NUM_COUNTERS; ++i) {
+        std::cout << " " << instr::counter_name(static_cast<instr::Counter>(i)) << ": " << counters[i] << "\n";
+    }
+    if (!instr::write_chrome_trace(path)) {
+        std::cerr << "Write trace " << path << " failed\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::shared_ptr<const DenseMap>> maps;
+    for (int i = 0; i < opts.maps; ++i) {
+        // only the map is used, a missing corpus start / goal does not matter here
+        CorpusMap cm;
+        make_corpus_map(MAP_CLUTTERED, opts.map_size, opts.map_size / opts.cells,
+            opts.seed + static_cast<unsigned int>(i), cm);
+        maps.push_back(std::make_shared<const DenseMap>(std::move(cm.map)));
+    }
+    if (opts.gen > 0) {
+        return gen_requests(opts, maps);
+    }
+
+    std::ifstream file;
+    if (std::strcmp(opts.requests, "-") != 0) {
+        file.open(opts.requests);
+        if (!file) {
+            std::cerr << "Open requests " << opts.requests << " failed\n";
+            return 1;
+        }
+    }
+    std::istream& in{file.is_open() ? file : std::cin};
+
+    const ServiceConfig cfg{
+        .kin={.wheel_base=WHEEL_BASE, .method=integ::INTEG_ARC, .tolerance=1.0e-3f},
+        .max_expansions=HAS_MAX_EXPANSIONS,
+        .rrt_max_iter=10000,
+        .rrt_goal_dist=2.0f,
+        .arena_block=1 << 20,
+        .seed=opts.seed
+    };
+    PlannerService service{cfg, opts.threads};
+    for (int i = 0; i < opts.maps; ++i) {
+        service.add_map(i, maps[i]);
+    }
+
+    // requests are dispatched as they are read
+    const auto start{std::chrono::steady_clock::now()};
+    std::string line;
+    long id{0};
+    long line_no{0};
+    PlanRequest req;
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (line.empty() || line[0] == '#') continue;
+        if (!parse_request(line, id, req)) {
+            std::cerr << "Skip malformed request at line " << line_no << "\n";
+            continue;
+        }
+        service.submit(req);
+        ++id;
+    }
+
+    std::vector<PlanResult> results;
+    service.drain(results);
+    const std::chrono::duration<double> wall{std::chrono::steady_clock::now() - start};
+
+    if (opts.print) {
+        for (const auto& r : results) {
+            std::cout << r.id << " " << stringify(r.planner) << " map " << r.map_id
+                      << (r.error == PLAN_UNKNOWN_MAP ? " unknown map" : r.found ? " found" : " failed")
+                      << ", expansions: " << r.expansions
+                      << ", path: " << r.path_size << " states, " << r.path_cost << " m"
+                      << ", plan: " << r.plan_ms << " ms\n";
+        }
+    }
+    report(results, service.size(), wall.count(), service.arena_peak());
+    if (opts.trace != nullptr) {
+        write_trace(opts.trace);
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "planner_service.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include "instrument.hpp"
+
+#define THREAD_POOL_IMPLEMENTATION
+#include "thread_pool.hpp"
+
+const std::string& stringify(PlannerType p)
+{
+    static std::string hybrid_a_star{"hybrid_a_star"};
+    static std::string rrt{"rrt"};
+    static std::string unknown{"unknown"};
+
+    switch (p) {
+    case PLANNER_HYBRID_A_STAR: return hybrid_a_star;
+    case PLANNER_RRT: return rrt;
+    case NUM_PLANNERS: break;
+    }
+    return unknown;
+}
+
+bool parse_planner(const std::string& name, PlannerType& p)
+{
+    for (int i = 0; i < NUM_PLANNERS; ++i) {
+        if (name == stringify(static_cast<PlannerType>(i))) {
+            p = static_cast<PlannerType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// seed of one request, independent of which worker runs it
+static inline unsigned int request_seed(unsigned int seed, long id)
+{
+    uint64_t z{seed + (static_cast<uint64_t>(id) + 1) * 0x9e3779b97f4a7c15ull};
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<unsigned int>(z ^ (z >> 31));
+}
+
+PlannerService::PlannerService(const ServiceConfig& cfg, int num_workers)
+    : cfg_(cfg)
+    , pool_(num_workers)
+{
+    workers_.reserve(pool_.size());
+    for (int i = 0; i < pool_.size(); ++i) {
+        workers_.push_back(std::make_unique<Worker>(cfg_.arena_block));
+    }
+}
+
+PlannerService::~PlannerService()
+{
+    // the queued requests still use the workers
+    pool_.wait();
+}
+
+void PlannerService::add_map(int map_id, std::shared_ptr<const DenseMap> map)
+{
+    maps_[map_id] = std::move(map);
+}
+
+void PlannerService::submit(const PlanRequest& req)
+{
+    const auto enqueued{std::chrono::steady_clock::now()};
+    pool_.submit([this, req, enqueued](int id) {
+        auto& worker{*workers_[id]};
+        const std::chrono::duration<double, std::milli> wait{std::chrono::steady_clock::now() - enqueued};
+        auto result{run(req, worker)};
+        result.wait_ms = wait.count();
+        result.arena_bytes = worker.arena.used();
+        worker.arena.reset();
+        worker.results.push_back(result);
+    });
+}
+
+void PlannerService::drain(std::vector<PlanResult>& results)
+{
+    pool_.wait();
+    for (auto& w : workers_) {
+        results.insert(results.end(), w->results.begin(), w->results.end());
+        w->results.clear();
+    }
+    std::sort(results.begin(), results.end(), [](const PlanResult& a, const PlanResult& b) { return a.id < b.id; });
+}
+
+size_t PlannerService::arena_peak() const
+{
+    size_t peak{0};
+    for (const auto& w : workers_) {
+        peak = std::max(peak, w->arena.peak());
+    }
+    return peak;
+}
+
+PlanResult PlannerService::run(const PlanRequest& req, Worker& worker) const
+{
+    INSTR_SCOPE("planner_service.run");
+    PlanResult result{
+        .id=req.id,
+        .planner=req.planner,
+        .map_id=req.map_id,
+        .error=PLAN_OK,
+        .found=false,
+        .expansions=0,
+        .path_size=0,
+        .path_cost=INFINITY,
+        .wait_ms=0.0,
+        .plan_ms=0.0,
+        .arena_bytes=0
+    };
+    const auto it{maps_.find(req.map_id)};
+    if (it == maps_.end()) {
+        result.error = PLAN_UNKNOWN_MAP;
+        return result;
+    }
+    const DenseMap* map{it->second.get()};
+
+    const auto start{std::chrono::steady_clock::now()};
+    if (req.planner == PLANNER_HYBRID_A_STAR) {
+        const State init{.x=req.init.x, .y=req.init.y, .heading=req.init.heading};
+        const State goal{.x=req.goal.x, .y=req.goal.y, .heading=req.goal.heading};
+        HybridAStar has{init, goal, cfg_.kin, map, &worker.arena};
+        result.found = has.search(cfg_.max_expansions);
+        result.expansions = has.expansions();
+        if (result.found && has.extract_path(worker.has_path)) {
+            result.path_size = worker.has_path.size();
+            result.path_cost = has.path_cost();
+        }
+    } else if (req.planner == PLANNER_RRT) {
+        const RRT::State init{.x=req.init.x, .y=req.init.y, .heading=req.init.heading, .parent=-1};
+        const RRT::State goal{.x=req.goal.x, .y=req.goal.y, .heading=req.goal.heading, .parent=-1};
+        RRT rrt{goal, cfg_.kin, map, &worker.arena, request_seed(cfg_.seed, req.id)};
+        result.found = rrt.search(init, cfg_.rrt_max_iter, cfg_.rrt_goal_dist);
+        result.expansions = rrt.graph().size();
+        worker.rrt_path.clear();
+        if (result.found && rrt.extract_path(worker.rrt_path)) {
+            result.path_size = worker.rrt_path.size();
+            result.path_cost = 0.0f;
+            for (size_t i = 1; i < worker.rrt_path.size(); ++i) {
+                result.path_cost += euclidean_dist(worker.rrt_path[i - 1], worker.rrt_path[i]);
+            }
+        }
+    }
+    const std::chrono::duration<double, std::milli> plan_time{std::chrono::steady_clock::now() - start};
+    result.plan_ms = plan_time.count();
+    return result;
+}
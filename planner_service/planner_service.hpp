@@ -0,0 +1,105 @@
+#ifndef PLANNER_SERVICE_PLANNER_SERVICE_H_
+#define PLANNER_SERVICE_PLANNER_SERVICE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arena.hpp"
+#include "hybrid_a_star.hpp"
+#include "integrator.hpp"
+#include "map_corpus.hpp"
+#include "map_gen.hpp"
+#include "rrt.hpp"
+#include "thread_pool.hpp"
+
+enum PlannerType {
+    PLANNER_HYBRID_A_STAR = 0,
+    PLANNER_RRT,
+    NUM_PLANNERS,
+}; // enum PlannerType
+
+const std::string& stringify(PlannerType p);
+// false if the name is not a planner
+bool parse_planner(const std::string& name, PlannerType& p);
+
+enum PlanError {
+    PLAN_OK = 0,            // planned, found or not
+    PLAN_UNKNOWN_MAP,       // no map was added under the map id, nothing planned
+}; // enum PlanError
+
+struct PlanRequest
+{
+    long id;
+    PlannerType planner;
+    int map_id;
+    Pose init;
+    Pose goal;
+}; // struct PlanRequest
+
+struct PlanResult
+{
+    long id;
+    PlannerType planner;
+    int map_id;
+    PlanError error;
+    bool found;
+    size_t expansions;      // expanded states for HybridAStar, tree nodes for RRT
+    size_t path_size;
+    float path_cost;        // meter
+    double wait_ms;         // queued before a worker picked it up
+    double plan_ms;
+    size_t arena_bytes;     // taken from the worker arena by this query
+}; // struct PlanResult
+
+struct ServiceConfig
+{
+    integ::KinematicConfig kin;
+    size_t max_expansions;  // HybridAStar
+    int rrt_max_iter;
+    float rrt_goal_dist;    // meter
+    size_t arena_block;     // bytes
+    unsigned int seed;      // RRT samples of a request depend on it and the request id only
+}; // struct ServiceConfig
+
+// Plans requests on a worker pool. Every worker owns an arena that backs all
+// the search containers of a query and is reset once the query is done, maps
+// are registered up front and shared read-only by all the workers.
+class PlannerService
+{
+public:
+    explicit PlannerService(const ServiceConfig& cfg, int num_workers = 0);
+    ~PlannerService();
+    PlannerService(const PlannerService&) = delete;
+    PlannerService& operator=(const PlannerService&) = delete;
+
+    // not thread safe, add every map before the first submit
+    void add_map(int map_id, std::shared_ptr<const DenseMap> map);
+    void submit(const PlanRequest& req);
+    // block until every submitted request is done, then move their results out
+    void drain(std::vector<PlanResult>& results);
+
+    inline int size() const { return pool_.size(); }
+    // most bytes one query took from an arena
+    size_t arena_peak() const;
+private:
+    // results stay per worker until drained so nothing is shared while running
+    struct alignas(64) Worker
+    {
+        explicit Worker(size_t block) : arena(block) {}
+        Arena arena;
+        std::vector<PlanResult> results;
+        std::vector<State> has_path;        // reused by every query
+        std::vector<RRT::State> rrt_path;
+    }; // struct Worker
+
+    PlanResult run(const PlanRequest& req, Worker& worker) const;
+
+    ServiceConfig cfg_;
+    std::unordered_map<int, std::shared_ptr<const DenseMap>> maps_;
+    tp::ThreadPool pool_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+}; // class PlannerService
+
+#endif // PLANNER_SERVICE_PLANNER_SERVICE_H_
@@ -0,0 +1,146 @@
+#include "rrt.hpp"
+#include <algorithm>
+#include "instrument.hpp"
+
+RRT::RRT(const State& goal, const integ::KinematicConfig& kin, const DenseMap* map, Arena* arena, unsigned int seed)
+    : goal_(goal)
+    , g_(arena)
+    , kin_(kin)
+    , map_(map)
+    , rng_(seed)
+    , viz_(nullptr)
+{}
+
+bool RRT::random_point(State& point)
+{
+    std::uniform_real_distribution<float> rand_01{0.0f, 1.0f};
+    if (map_ != nullptr) {
+        point.x = rand_01(rng_) * (map_->x_range[1] - map_->x_range[0]) + map_->x_range[0];
+        point.y = rand_01(rng_) * (map_->y_range[1] - map_->y_range[0]) + map_->y_range[0];
+        return false;
+    }
+    point.x = rand_01(rng_) * MAP_X_SIZE + MAP_X_MIN;
+    point.y = rand_01(rng_) * MAP_Y_SIZE + MAP_Y_MIN;
+    return false;
+}
+
+bool RRT::search(const State& init, int max_iter, float short_distance)
+{
+    State rand_point;
+    State nearest_node;
+    State new_node;
+    float nearest_node_to_goal{1.0e6f};
+
+    INSTR_SCOPE("rrt.search");
+    if (collides(init)) return false;
+
+    g_.add_init_node(init);
+    for (int i = 0; i < max_iter; ++i) {
+        random_point(rand_point);
+        const int nearest_idx{g_.find_nearest(rand_point)};
+        if (nearest_idx < 0) continue;
+
+        nearest_node = g_.node(nearest_idx);
+        if (!steer(nearest_node, rand_point, new_node)) continue;
+
+        g_.add_edges(nearest_idx, new_node);
+        INSTR_COUNT(instr::CNT_EXPANSIONS);
+        VIZ_DRAW(viz_, segment(viz::LAYER_TREE, nearest_node.x, nearest_node.y, new_node.x, new_node.y));
+        nearest_node_to_goal = std::min(nearest_node_to_goal, euclidean_dist(new_node, goal_));
+        if (nearest_node_to_goal < short_distance) {
+            break;
+        }
+    }
+
+    if (nearest_node_to_goal < short_distance) {
+        return true;
+    }
+    return false;
+}
+
+bool RRT::steer(const State& from, const State& to, State& new_state)
+{
+    constexpr float steer_start{-0.5f}; // rad
+    constexpr float steer_end{0.5f};    // rad
+    constexpr float steer_inc{0.1f};    // rad
+    constexpr float step_size{0.5f};    // meter
+
+    float min_dist{1.0e6f};
+    State tmp_state;
+    for (float s = steer_start; s < steer_end; s += steer_inc) {
+        tmp_state = from;
+        integ::step(tmp_state, kin_, s, step_size);
+        const float this_dist{euclidean_dist(tmp_state, to)};
+        if (this_dist < min_dist) {
+            min_dist = this_dist;
+            new_state = tmp_state;
+        }
+    }
+
+    return !collides(new_state);
+}
+
+bool RRT::collides(const State& s) const
+{
+    INSTR_COUNT(instr::CNT_COLLISION_CHECKS);
+    if (map_ == nullptr) return false;
+    const int idx{grid_index(*map_, s.x, s.y)};
+    return idx < 0 || map_->grid_status[idx] > 0;
+}
+
+bool RRT::extract_path(std::vector<State>& path)
+{
+    if (g_.empty()) return false;
+
+    State curr{g_.last_node()};
+    path.push_back(curr);
+    while (curr.parent >= 0) {
+        curr = g_.node(curr.parent);
+        path.push_back(curr);
+    }
+
+    return true;
+}
+
+RRT::Graph::Graph(Arena* arena)
+    : vertices_(arena)
+{}
+
+bool RRT::Graph::add_init_node(const State& point)
+{
+    vertices_.push(point);
+    vertices_.back().parent = -1;
+    return true;
+}
+
+bool RRT::Graph::add_edges(int src, const State& b)
+{
+    vertices_.push(b);
+    vertices_.back().parent = src;
+    return true;
+}
+
+int RRT::Graph::find_nearest(const State& ref) const
+{
+    INSTR_COUNT(instr::CNT_NN_QUERIES);
+    if (vertices_.empty()) {
+        return -1;
+    }
+
+    // squared distances over one contiguous chunk at a time
+    int result{-1};
+    float min_dist{1.0e12f};
+    for (size_t c = 0; c < vertices_.num_chunks(); ++c) {
+        const State* nodes{vertices_.chunk(c)};
+        const uint32_t n{vertices_.chunk_size(c)};
+        for (uint32_t i = 0; i < n; ++i) {
+            const auto this_dist{pow2(nodes[i].x - ref.x) + pow2(nodes[i].y - ref.y)};
+            if (this_dist < min_dist) {
+                min_dist = this_dist;
+                result = static_cast<int>(c * NodePool<State>::CHUNK_SIZE + i);
+            }
+        }
+    }
+
+    return result;
+}
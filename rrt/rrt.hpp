@@ -0,0 +1,76 @@
+#ifndef RRT_RRT_H_
+#define RRT_RRT_H_
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "arena.hpp"
+#include "integrator.hpp"
+#include "map_gen.hpp"
+#include "math_util.hpp"
+#include "node_pool.hpp"
+#include "viz_sink.hpp"
+
+#define MAP_X_MIN   0.0f                        // meter
+#define MAP_X_MAX   200.0f                      // meter
+#define MAP_X_SIZE  (MAP_X_MAX - MAP_X_MIN)     // meter
+#define MAP_Y_MIN   0.0f                        // meter
+#define MAP_Y_MAX   200.0f                      // meter
+#define MAP_Y_SIZE  (MAP_Y_MAX - MAP_Y_MIN)     // meter
+
+
+class RRT
+{
+public:
+    struct State
+    {
+        float x;
+        float y;
+        float heading;
+        int parent;
+    }; // struct State
+
+    struct Graph
+    {
+        explicit Graph(Arena* arena = nullptr);
+        ~Graph() = default;
+        bool add_init_node(const State& point);
+        bool add_edges(int src_idx, const State& b);
+        int find_nearest(const State& ref) const;
+
+        inline State& last_node() { return vertices_.back(); }
+        inline State& node(int idx) { return vertices_[idx]; }
+        inline const State& node(int idx) const { return vertices_[idx]; }
+        inline bool empty() const { return vertices_.empty(); }
+        inline size_t size() const { return vertices_.size(); }
+        inline size_t bytes() const { return vertices_.bytes(); }
+    private:
+        NodePool<State> vertices_;
+    }; // struct Graph
+
+    // samples are drawn over the map and new nodes on occupied cells are
+    // dropped when a map is given, the tree allocates from the arena when one is given
+    RRT(const State& goal, const integ::KinematicConfig& kin, const DenseMap* map = nullptr,
+        Arena* arena = nullptr, unsigned int seed = 0);
+    ~RRT() = default;
+    bool search(const State& init, int max_iter, float short_distance);
+    bool extract_path(std::vector<State>& path);
+
+    inline const Graph& graph() const { return g_; }
+    // every new tree edge is drawn as a segment on LAYER_TREE, nullptr draws nothing
+    inline void set_viz(viz::VizSink* sink) { viz_ = sink; }
+private:
+    State goal_;
+    Graph g_;
+    integ::KinematicConfig kin_;
+    const DenseMap* map_;
+    std::mt19937 rng_;
+    viz::VizSink* viz_;
+
+    bool random_point(State& point);
+    bool steer(const State& from, const State& to, State& new_state);
+    bool collides(const State& s) const;
+}; // class RRT
+
+#endif // RRT_RRT_H_